@@ -12,6 +12,7 @@
 #include <linux/printk.h>
 #include <linux/atomic.h>
 #include <linux/gpio/consumer.h>
+#include <linux/interrupt.h>
 #include <linux/i2c.h>
 #include <linux/platform_device.h>
 #include <linux/netdevice.h>
@@ -22,6 +23,7 @@
 #include <net/ip_fib.h>
 #include <net/ip6_fib.h>
 #include <net/netevent.h>
+#include <net/nexthop.h>
 #include <net/rtnetlink.h>
 
 #include <generated/uapi/linux/version.h>
@@ -33,6 +35,47 @@
 #  define fib_notifier_info_without_net true
 #endif
 
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0))
+#  define nexthop_notifier_info_type true
+#endif
+
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(6, 0, 0))
+#  define xeth_mux_devlink true
+#endif
+
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(5, 13, 0))
+#  define xeth_mux_xdp true
+#endif
+
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0))
+#  define xeth_mux_xdp_features true
+#endif
+
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0))
+#  define xeth_bpf_net_ctx true
+#endif
+
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0))
+#  define xeth_do_xdp_generic(prog, pskb)	do_xdp_generic(prog, pskb)
+#else
+#  define xeth_do_xdp_generic(prog, pskb)	do_xdp_generic(prog, *(pskb))
+#endif
+
+#if defined(LINUX_VERSION_CODE) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0))
+#  define xeth_netif_napi_add(nd, napi, poll)	\
+	netif_napi_add(nd, napi, poll)
+#else
+#  define xeth_netif_napi_add(nd, napi, poll)	\
+	netif_napi_add(nd, napi, poll, NAPI_POLL_WEIGHT)
+#endif
+
 extern const char *xeth_mod_name;
 
 #define xeth_debug(format, args...)					\
@@ -372,6 +415,12 @@ void xeth_mux_check_lower_carrier(struct net_device *mux);
 void xeth_mux_del_vlans(struct net_device *mux, struct net_device *nd,
 			struct list_head *unregq);
 void xeth_mux_dump_all_ifinfo(struct net_device *);
+void xeth_mux_reset_all_stats(struct net_device *);
+void xeth_mux_flush_journal(struct net_device *);
+void xeth_mux_resync(struct net_device *, u64 gen);
+void xeth_mux_synced(struct net_device *);
+void xeth_mux_yield_sbtx(struct net_device *);
+void xeth_mux_reconcile(struct net_device *);
 
 const unsigned short * const xeth_mux_qsfp_i2c_addrs(struct net_device *mux);
 struct gpio_desc *xeth_mux_qsfp_absent_gpio(struct net_device *mux, size_t prt);
@@ -384,6 +433,14 @@ int xeth_mux_qsfp_bus(struct net_device *mux, size_t port);
 enum xeth_mux_counter {
 	xeth_mux_counter_ex_frames,
 	xeth_mux_counter_ex_bytes,
+	xeth_mux_counter_ex_arp_dropped,
+	xeth_mux_counter_ex_nd_dropped,
+	xeth_mux_counter_ex_ttl_dropped,
+	xeth_mux_counter_ex_bgp_dropped,
+	xeth_mux_counter_ex_ctl_dropped,
+	xeth_mux_counter_ex_other_dropped,
+	xeth_mux_counter_proxy_tx_stopped,
+	xeth_mux_counter_xdp_consumed,
 	xeth_mux_counter_sb_connections,
 	xeth_mux_counter_sbex_invalid,
 	xeth_mux_counter_sbex_dropped,
@@ -398,6 +455,9 @@ enum xeth_mux_counter {
 	xeth_mux_counter_sbtx_queued,
 	xeth_mux_counter_sbtx_free,
 	xeth_mux_counter_sbtx_ticks,
+	xeth_mux_counter_sbtx_fib_covered,
+	xeth_mux_counter_sbtx_resyncs,
+	xeth_mux_counter_sbtx_overflows,
 	xeth_mux_n_counters,
 };
 
@@ -406,6 +466,14 @@ enum xeth_mux_counter {
 #define xeth_mux_counter_names()					\
 	xeth_mux_counter_name(ex_frames),				\
 	xeth_mux_counter_name(ex_bytes),				\
+	xeth_mux_counter_name(ex_arp_dropped),				\
+	xeth_mux_counter_name(ex_nd_dropped),				\
+	xeth_mux_counter_name(ex_ttl_dropped),				\
+	xeth_mux_counter_name(ex_bgp_dropped),				\
+	xeth_mux_counter_name(ex_ctl_dropped),				\
+	xeth_mux_counter_name(ex_other_dropped),			\
+	xeth_mux_counter_name(proxy_tx_stopped),			\
+	xeth_mux_counter_name(xdp_consumed),				\
 	xeth_mux_counter_name(sb_connections),				\
 	xeth_mux_counter_name(sbex_invalid),				\
 	xeth_mux_counter_name(sbex_dropped),				\
@@ -420,6 +488,9 @@ enum xeth_mux_counter {
 	xeth_mux_counter_name(sbtx_queued),				\
 	xeth_mux_counter_name(sbtx_free),				\
 	xeth_mux_counter_name(sbtx_ticks),				\
+	xeth_mux_counter_name(sbtx_fib_covered),			\
+	xeth_mux_counter_name(sbtx_resyncs),				\
+	xeth_mux_counter_name(sbtx_overflows),				\
 	[xeth_mux_n_counters] = NULL
 
 static inline void xeth_mux_counter_init(atomic64_t *t)
@@ -483,6 +554,14 @@ xeth_mux_set_##name(struct net_device *mux, s64 n)			\
 
 xeth_mux_counter_ops(ex_frames)
 xeth_mux_counter_ops(ex_bytes)
+xeth_mux_counter_ops(ex_arp_dropped)
+xeth_mux_counter_ops(ex_nd_dropped)
+xeth_mux_counter_ops(ex_ttl_dropped)
+xeth_mux_counter_ops(ex_bgp_dropped)
+xeth_mux_counter_ops(ex_ctl_dropped)
+xeth_mux_counter_ops(ex_other_dropped)
+xeth_mux_counter_ops(proxy_tx_stopped)
+xeth_mux_counter_ops(xdp_consumed)
 xeth_mux_counter_ops(sb_connections)
 xeth_mux_counter_ops(sbex_invalid)
 xeth_mux_counter_ops(sbex_dropped)
@@ -497,6 +576,9 @@ xeth_mux_counter_ops(sbtx_no_mem)
 xeth_mux_counter_ops(sbtx_queued)
 xeth_mux_counter_ops(sbtx_free)
 xeth_mux_counter_ops(sbtx_ticks)
+xeth_mux_counter_ops(sbtx_fib_covered)
+xeth_mux_counter_ops(sbtx_resyncs)
+xeth_mux_counter_ops(sbtx_overflows)
 
 enum xeth_mux_flag {
 	xeth_mux_flag_main_task,
@@ -508,6 +590,15 @@ enum xeth_mux_flag {
 	xeth_mux_flag_inet6addr_notifier,
 	xeth_mux_flag_netdevice_notifier,
 	xeth_mux_flag_netevent_notifier,
+	xeth_mux_flag_sb_compact,
+	xeth_mux_flag_sb_gen,
+	xeth_mux_flag_sb_grace,
+	xeth_mux_flag_sb_dumping,
+	xeth_mux_flag_sb_ifinfo_dirty,
+	xeth_mux_flag_sb_fibinfo_dirty,
+	xeth_mux_flag_sb_ifinfo_dump,
+	xeth_mux_flag_sb_regen,
+	xeth_mux_flag_sb_resync,
 	xeth_mux_n_flags,
 };
 
@@ -522,6 +613,15 @@ enum xeth_mux_flag {
 	xeth_mux_flag_name(inet6addr_notifier),				\
 	xeth_mux_flag_name(netdevice_notifier),				\
 	xeth_mux_flag_name(netevent_notifier),				\
+	xeth_mux_flag_name(sb_compact),					\
+	xeth_mux_flag_name(sb_gen),					\
+	xeth_mux_flag_name(sb_grace),					\
+	xeth_mux_flag_name(sb_dumping),					\
+	xeth_mux_flag_name(sb_ifinfo_dirty),				\
+	xeth_mux_flag_name(sb_fibinfo_dirty),				\
+	xeth_mux_flag_name(sb_ifinfo_dump),				\
+	xeth_mux_flag_name(sb_regen),					\
+	xeth_mux_flag_name(sb_resync),					\
 	[xeth_mux_n_flags] = NULL,
 
 #define xeth_mux_flag_ops(name)						\
@@ -567,12 +667,24 @@ xeth_mux_flag_ops(inetaddr_notifier)
 xeth_mux_flag_ops(inet6addr_notifier)
 xeth_mux_flag_ops(netdevice_notifier)
 xeth_mux_flag_ops(netevent_notifier)
-
+xeth_mux_flag_ops(sb_compact)
+xeth_mux_flag_ops(sb_gen)
+xeth_mux_flag_ops(sb_grace)
+xeth_mux_flag_ops(sb_dumping)
+xeth_mux_flag_ops(sb_ifinfo_dirty)
+xeth_mux_flag_ops(sb_fibinfo_dirty)
+xeth_mux_flag_ops(sb_ifinfo_dump)
+xeth_mux_flag_ops(sb_regen)
+xeth_mux_flag_ops(sb_resync)
+
+/* @stopped: the nexthop notifier awaits unregister outside of rtnl */
 struct xeth_fibmuxnet {
 	struct list_head list;
 	struct notifier_block fib;
+	struct notifier_block nh;
 	struct net_device *mux;
 	struct net *net;
+	bool stopped;
 };
 
 static inline void xeth_mux_fib_cb(struct notifier_block *fib)
@@ -593,17 +705,33 @@ xeth_fibmuxnet_net(struct xeth_fibmuxnet *fmn,
 #endif
 }
 
+/* register the nexthop notifier first so that its dump of nexthop objects
+ * precedes the routes that refer to them
+ */
 static inline int xeth_fibmuxnet_register(struct xeth_fibmuxnet *fmn)
 {
-	return
+	int err;
+
+#if defined(nexthop_notifier_info_type)
+	err = register_nexthop_notifier(fmn->net, &fmn->nh, NULL);
+	if (err)
+		return err;
+#endif
+	err =
 #if defined(fib_notifier_info_with_net)
 	register_fib_notifier(&fmn->fib, xeth_mux_fib_cb);
 #else
 	register_fib_notifier(fmn->net, &fmn->fib, xeth_mux_fib_cb, NULL);
 #endif
+#if defined(nexthop_notifier_info_type)
+	if (err)
+		unregister_nexthop_notifier(fmn->net, &fmn->nh);
+#endif
+	return err;
 }
 
-static inline void xeth_fibmuxnet_unregister(struct xeth_fibmuxnet *fmn)
+/* unregister_nexthop_notifier() takes rtnl so xeth_nb_stop_fmn() defers it */
+static inline void xeth_fibmuxnet_unregister_fib(struct xeth_fibmuxnet *fmn)
 {
 #if defined(fib_notifier_info_with_net)
 	unregister_fib_notifier(&fmn->fib);
@@ -613,7 +741,9 @@ static inline void xeth_fibmuxnet_unregister(struct xeth_fibmuxnet *fmn)
 }
 
 struct xeth_nb {
+	/* @fibs: per-netns fib notifiers, only those w/ xeth proxies */
 	struct list_head fibs;
+	struct mutex fibs_mutex;
 	struct notifier_block inetaddr;
 	struct notifier_block inet6addr;
 	struct notifier_block netdevice;
@@ -623,14 +753,18 @@ struct xeth_nb {
 struct xeth_nb *xeth_mux_nb(struct net_device *mux);
 struct net_device *xeth_mux_of_nb(struct xeth_nb *);
 
-int xeth_nb_start_new_fib(struct net_device *mux, struct net *net);
+bool xeth_nb_has_net_fib(struct net_device *mux, struct net *net);
+int xeth_nb_start_net_fib(struct net_device *mux, struct net *net);
 int xeth_nb_start_all_fib(struct net_device *mux);
 int xeth_nb_start_inetaddr(struct net_device *mux);
 int xeth_nb_start_inet6addr(struct net_device *mux);
 int xeth_nb_start_netdevice(struct net_device *mux);
 int xeth_nb_start_netevent(struct net_device *mux);
 
+void xeth_nb_stop_net_fib(struct net_device *mux, struct net *net);
 void xeth_nb_stop_all_fib(struct net_device *mux);
+int xeth_nb_init(void);
+void xeth_nb_exit(void);
 void xeth_nb_stop_inetaddr(struct net_device *mux);
 void xeth_nb_stop_inet6addr(struct net_device *mux);
 void xeth_nb_stop_netdevice(struct net_device *mux);
@@ -657,6 +791,11 @@ void xeth_port_link_stat(struct net_device *nd, u32 index, u64 count);
 void xeth_port_speed(struct net_device *nd, u32 mbps);
 
 void xeth_port_reset_ethtool_stats(struct net_device *);
+bool xeth_port_carrier_stale(struct net_device *);
+void xeth_port_set_carrier_stale(struct net_device *, bool stale);
+void xeth_port_dump_qsfp(struct net_device *);
+bool xeth_port_has_qsfp(struct net_device *);
+void xeth_port_sample_dom(struct net_device *);
 
 /**
  * struct xeth_proxy -	first member of each xeth proxy device priv
@@ -670,9 +809,17 @@ struct xeth_proxy {
 	struct list_head __rcu	kin;
 	/* @quit: pending quit from lag or bridge */
 	struct list_head quit;
+	/* @vlans: VLAN proxies of this port or lag link */
+	struct list_head __rcu vlans;
+	/* @vlan: VLAN proxy entry of its link's @vlans */
+	struct list_head __rcu vlan;
+	/* @tx_stopped: entry of the mux's proxies stopped by backpressure */
+	struct list_head tx_stopped;
 	atomic64_t link_stats[XETH_N_LINK_STAT];
 	enum xeth_dev_kind kind;
 	u32 xid;
+	/* @dumped: epoch of the last ifinfo dump that reached this proxy */
+	u32 dumped;
 };
 
 #define xeth_proxy_of_kin(ptr)						\
@@ -685,7 +832,13 @@ struct xeth_proxy *xeth_mux_proxy_of_xid(struct net_device *mux, u32 xid);
 struct xeth_proxy *xeth_mux_proxy_of_nd(struct net_device *mux,
 					struct net_device *nd);
 
+bool xeth_mux_has_proxy_in_net(struct net_device *mux, struct net *net,
+			       struct net_device *except);
+
 void xeth_mux_add_proxy(struct xeth_proxy *);
+int xeth_mux_alloc_xid(struct net_device *mux, enum xeth_dev_kind kind);
+int xeth_mux_reserve_xid(struct net_device *mux, u32 xid);
+void xeth_mux_unlink_proxy(struct xeth_proxy *);
 void xeth_mux_del_proxy(struct xeth_proxy *);
 
 void xeth_proxy_dump_ifa(struct xeth_proxy *);
@@ -700,7 +853,11 @@ static inline void xeth_proxy_reset_link_stats(struct xeth_proxy *proxy)
 static inline void xeth_proxy_setup(struct net_device *nd)
 {
 	struct xeth_proxy *proxy = netdev_priv(nd);
+	INIT_HLIST_NODE(&proxy->node);
 	INIT_LIST_HEAD(&proxy->kin);
+	INIT_LIST_HEAD_RCU(&proxy->vlans);
+	INIT_LIST_HEAD(&proxy->vlan);
+	INIT_LIST_HEAD(&proxy->tx_stopped);
 	xeth_link_stat_init(proxy->link_stats);
 }
 
@@ -717,6 +874,16 @@ netdev_features_t xeth_proxy_fix_features(struct net_device *,
 					  netdev_features_t);
 int xeth_proxy_set_features(struct net_device *, netdev_features_t);
 
+/* decoded SFF-8636 digital diagnostic monitors */
+struct xeth_qsfp_dom {
+	s32 temp_mc;	/* millidegrees Celsius */
+	u32 vcc_uv;
+	u32 rx_power_nw[4];
+	u32 tx_bias_ua[4];
+	u32 tx_power_nw[4];
+};
+
+int xeth_qsfp_read_dom(struct i2c_client *qsfp, struct xeth_qsfp_dom *dom);
 int xeth_qsfp_get_module_info(struct i2c_client *qsfp,
 			      struct ethtool_modinfo *emi);
 int xeth_qsfp_get_module_eeprom(struct i2c_client *qsfp,
@@ -727,6 +894,8 @@ int xeth_qsfp_get_module_eeprom(struct i2c_client *qsfp,
  * @addrs: a I2C_CLIENT_END terminated list
  */
 struct i2c_client *xeth_qsfp_client(int nr, const unsigned short *addrs);
+void xeth_qsfp_unregister(struct i2c_client *qsfp);
+void xeth_qsfp_invalidate(struct i2c_client *qsfp);
 
 extern struct rtnl_link_ops xeth_vlan_lnko;
 
@@ -761,6 +930,7 @@ struct xeth_sbtxb *xeth_mux_alloc_sbtxb(struct net_device *mux, size_t);
 void xeth_mux_queue_sbtx(struct net_device *mux, struct xeth_sbtxb *);
 
 int xeth_sbtx_break(struct net_device *);
+void xeth_sbtx_dump_required(struct xeth_sbtxb *, u8 dumps);
 int xeth_sbtx_change_upper(struct net_device *, u32 upper_xid, u32 lower_xid,
 			   bool linking);
 int xeth_sbtx_et_flags(struct net_device *, u32 xid, u32 flags);
@@ -772,6 +942,9 @@ int xeth_sbtx_fib_entry(struct net_device *, struct net *net,
 int xeth_sbtx_fib6_entry(struct net_device *, struct net *net,
 			 struct fib6_entry_notifier_info *feni,
 			 unsigned long event);
+int xeth_sbtx_fib_flush(struct net_device *, struct net *net, u32 table);
+int xeth_sbtx_fib_flush_dev(struct xeth_proxy *);
+int xeth_sbtx_gen(struct net_device *, enum xeth_msg_kind kind, u64 gen);
 int xeth_sbtx_ifa(struct net_device *, struct in_ifaddr *ifa,
 		  unsigned long event, u32 xid);
 int xeth_sbtx_ifa6(struct net_device *, struct inet6_ifaddr *ifa,
@@ -780,6 +953,10 @@ int xeth_sbtx_ifinfo(struct xeth_proxy *, unsigned iff,
 		     enum xeth_msg_ifinfo_reason);
 int xeth_sbtx_neigh_update(struct net_device *, struct neighbour *neigh);
 int xeth_sbtx_netns(struct net_device *, u64 ns_inum, bool add);
+int xeth_sbtx_qsfp(struct net_device *, u32 xid, enum xeth_qsfp_event event);
+int xeth_sbtx_nexthop(struct net_device *, struct net *net,
+		      struct nh_notifier_info *info,
+		      enum xeth_nexthop_event event);
 
 #if !defined(XETH_VERSION)
 #define XETH_VERSION "undefined"
@@ -794,7 +971,6 @@ static inline bool is_xeth_vlan(struct net_device *nd)
 	return nd->rtnl_link_ops == &xeth_vlan_lnko;
 }
 
-bool xeth_vlan_has_link(const struct net_device *nd,
-			const struct net_device *link);
+struct net_device *xeth_vlan_link(const struct net_device *nd);
 
 #endif /* __NET_ETHERNET_XETH_H */
@@ -230,13 +230,12 @@ static int xeth_lag_newlink(struct net *src_net, struct net_device *lag,
 	lag->min_mtu = link->min_mtu;
 	lag->max_mtu = link->max_mtu;
 
-	for (priv->proxy.xid = 3000;
-	     xeth_mux_proxy_of_xid(priv->proxy.mux, priv->proxy.xid);
-	     priv->proxy.xid++)
-		if (priv->proxy.xid == 4095) {
-			NL_SET_ERR_MSG(extack, "failed xid alloc");
-			return -ENODEV;
-		}
+	err = xeth_mux_alloc_xid(priv->proxy.mux, XETH_DEV_KIND_LAG);
+	if (err < 0) {
+		NL_SET_ERR_MSG(extack, "failed xid alloc");
+		return err;
+	}
+	priv->proxy.xid = err;
 	xeth_mux_add_proxy(&priv->proxy);
 
 	if (err = register_netdevice(lag), err < 0) {
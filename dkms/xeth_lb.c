@@ -129,13 +129,12 @@ static int xeth_lb_newlink(struct net *src_net, struct net_device *nd,
 	if (data && data[XETH_LB_IFLA_CHANNEL])
 		priv->chan  = nla_get_u16(data[XETH_LB_IFLA_CHANNEL]);
 
-	for (priv->proxy.xid = 3000;
-	     xeth_mux_proxy_of_xid(priv->proxy.mux, priv->proxy.xid);
-	     priv->proxy.xid++)
-		if (priv->proxy.xid == 4095) {
-			NL_SET_ERR_MSG(extack, "failed xid alloc");
-			return -ENODEV;
-		}
+	err = xeth_mux_alloc_xid(priv->proxy.mux, XETH_DEV_KIND_LB);
+	if (err < 0) {
+		NL_SET_ERR_MSG(extack, "failed xid alloc");
+		return err;
+	}
+	priv->proxy.xid = err;
 	xeth_mux_add_proxy(&priv->proxy);
 
 	err = register_netdevice(nd);
@@ -45,6 +45,9 @@ static int __init xeth_mod_init(void)
 
 	no_xeth_debug_test();
 	no_xeth_err_test();
+	err = xeth_nb_init();
+	if (err)
+		return err;
 	for (drvr = xeth_mod_drivers; err >= 0 && (*drvr); drvr++)
 		err = platform_driver_register(*drvr);
 	for (lnko = xeth_mod_lnkos; err >= 0 && (*lnko); lnko++)
@@ -54,6 +57,7 @@ static int __init xeth_mod_init(void)
 			platform_driver_unregister(*(--drvr));
 		while (lnko != xeth_mod_lnkos)
 			rtnl_link_unregister(*(--lnko));
+		xeth_nb_exit();
 	}
 	return err;
 }
@@ -69,6 +73,7 @@ static void __exit xeth_mod_exit(void)
 	for (lnko = xeth_mod_lnkos; *lnko; lnko++)
 		if ((*lnko)->list.next || (*lnko)->list.prev)
 			rtnl_link_unregister(*lnko);
+	xeth_nb_exit();
 }
 module_exit(xeth_mod_exit);
 
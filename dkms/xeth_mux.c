@@ -13,17 +13,191 @@
 #include <linux/un.h>
 #include <linux/i2c.h>
 #include <linux/of_device.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <net/devlink.h>
+#include <net/ip.h>
+#include <linux/vmalloc.h>
+#include <net/ipv6.h>
+#include <net/ndisc.h>
+#include <net/sch_generic.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
 #include <uapi/linux/time.h>
 
 static const char xeth_mux_drvname[] = "xeth-mux";
 
+static unsigned int xeth_mux_carrier_grace_ms = 10000;
+
+module_param_named(carrier_grace_ms, xeth_mux_carrier_grace_ms, uint, 0644);
+MODULE_PARM_DESC(carrier_grace_ms,
+		 " keep port carrier this long after sideband disconnect"
+		 " (default 10000, 0 drops it immediately)");
+
+static unsigned int xeth_mux_sbtx_max_queued = 1 << 16;
+
+module_param_named(sbtx_max_queued, xeth_mux_sbtx_max_queued, uint, 0644);
+MODULE_PARM_DESC(sbtx_max_queued,
+		 " drop updates and request dumps past this many queued"
+		 " sideband messages (default 65536)");
+
+static unsigned int xeth_mux_sbtx_max_kib = 32 << 10;
+
+module_param_named(sbtx_max_kib, xeth_mux_sbtx_max_kib, uint, 0644);
+MODULE_PARM_DESC(sbtx_max_kib,
+		 " drop updates and request dumps past this many KiB of"
+		 " queued sideband messages (default 32768)");
+
+static unsigned int xeth_mux_qsfp_dom_ms = 250;
+
+module_param_named(qsfp_dom_ms, xeth_mux_qsfp_dom_ms, uint, 0644);
+MODULE_PARM_DESC(qsfp_dom_ms,
+		 " sample the diagnostic monitors of up to 8 QSFPs each period"
+		 " (default 250, 0 disables)");
+
+/* classes of exception frames policed before demux to their proxy */
+enum xeth_mux_ex {
+	xeth_mux_ex_arp,
+	xeth_mux_ex_nd,
+	xeth_mux_ex_ttl,
+	xeth_mux_ex_bgp,
+	/* link-local L2 protocols, e.g. LACP and LLDP; BFD; and IGP,
+	 * multicast, and VRRP control
+	 */
+	xeth_mux_ex_ctl,
+	xeth_mux_ex_other,
+	xeth_mux_n_ex,
+};
+
+static unsigned int xeth_mux_ex_pps[xeth_mux_n_ex] = {
+	[xeth_mux_ex_arp] = 1000,
+	[xeth_mux_ex_nd] = 1000,
+	[xeth_mux_ex_ttl] = 500,
+	[xeth_mux_ex_bgp] = 10000,
+	[xeth_mux_ex_ctl] = 2000,
+	[xeth_mux_ex_other] = 5000,
+};
+
+module_param_array_named(ex_pps, xeth_mux_ex_pps, uint, NULL, 0644);
+MODULE_PARM_DESC(ex_pps,
+		 " arp,nd,ttl,bgp,ctl,other exception frames per second"
+		 " (default 1000,1000,500,10000,2000,5000, 0 is unlimited)");
+
+/* The priority mark of exception frames leaves no PCP for the rx queue so
+ * use one by class; control protocols preempt punted data.
+ */
+static const u8 xeth_mux_ex_prio[xeth_mux_n_ex] = {
+	[xeth_mux_ex_arp] = 6,
+	[xeth_mux_ex_nd] = 6,
+	[xeth_mux_ex_ttl] = 1,
+	[xeth_mux_ex_bgp] = 6,
+	[xeth_mux_ex_ctl] = 7,
+	[xeth_mux_ex_other] = 0,
+};
+
+static unsigned int xeth_mux_rxq_len = 1000;
+
+module_param_named(rxq_len, xeth_mux_rxq_len, uint, 0644);
+MODULE_PARM_DESC(rxq_len,
+		 " drop demuxed frames past this many in each priority"
+		 " queue of each cpu (default 1000)");
+
+enum {
+	xeth_mux_max_steer = 64,
+};
+
+static unsigned int xeth_mux_steer[xeth_mux_max_steer];
+static int xeth_mux_n_steer;
+
+module_param_array_named(steer, xeth_mux_steer, uint, &xeth_mux_n_steer,
+			 0644);
+MODULE_PARM_DESC(steer,
+		 " receive demuxed frames of xid on cpu steer[xid % n]"
+		 " (default, the cpu that demuxed the frame)");
+
+/* PCP 7 marks exceptions so the map can't reach it */
+static unsigned int xeth_mux_egress_qos_map[TC_BITMASK + 1] = {
+	0, 1, 2, 3, 4, 5, 6, 6,
+};
+
+module_param_array_named(egress_qos_map, xeth_mux_egress_qos_map, uint, NULL,
+			 0644);
+MODULE_PARM_DESC(egress_qos_map,
+		 " encapsulation PCP of each transmit skb priority, 0 to 15"
+		 " (default 0,1,2,3,4,5,6,6,0,...; at most 6)");
+
+static unsigned int xeth_mux_ex_burst = 64;
+
+module_param_named(ex_burst, xeth_mux_ex_burst, uint, 0644);
+MODULE_PARM_DESC(ex_burst,
+		 " exception frames of each class admitted at once"
+		 " (default 64)");
+
 enum {
+	/* ms to wait for an in-flight rx IPI of each cpu on uninit */
+	xeth_mux_csd_flush_ms = 1000,
 	xeth_mux_proxy_hash_bits = 4,
 	xeth_mux_proxy_hash_bkts = 1 << xeth_mux_proxy_hash_bits,
 	xeth_mux_link_hash_bits = 4,
 	xeth_mux_link_hash_bkts = 1 << xeth_mux_link_hash_bits,
 	xeth_mux_max_links = 8,
 	xeth_mux_max_qsfp_i2c_addrs = 3,
+	xeth_mux_journal_sz = 1 << 20,
+	xeth_mux_ifinfo_dump_chunk = 32,
+	xeth_mux_dom_batch = 8,
+	/* ports count down from xeth_port_top_vid */
+	xeth_mux_port_xid_max = 3999,
+	/* lags, bridges, and loopbacks count up from here */
+	xeth_mux_upper_xid_min = 3000,
+	xeth_mux_upper_xid_max = XETH_VLAN_N_VID - 2,
+};
+
+/* each journal record is this header followed by @len bytes of message */
+struct xeth_mux_journaled {
+	u64 gen;
+	u64 len;
+};
+
+/* token bucket of @credit frame-nanoseconds filled since @stamp
+ * @devlink: police by the @pps and @burst of the class's devlink trap
+ *	policer rather than the ex_pps and ex_burst module parameters
+ * @trap_ctx: of the class's devlink trap, if registered
+ */
+struct xeth_mux_policer {
+	spinlock_t lock;
+	u64 credit, stamp;
+	bool devlink;
+	unsigned int pps, burst;
+	void *trap_ctx;
+};
+
+/* @nd: the proxy that receives the queued frame; skb->dev remains the mux or
+ * lower link so that forwarding still scrubs frames crossing namespaces
+ * @mark: if non-zero, the trap reason that is set after that scrub
+ */
+struct xeth_mux_rx_cb {
+	struct net_device *nd;
+	u32 mark;
+};
+
+#define xeth_mux_rx_cb(skb)	((struct xeth_mux_rx_cb *)(skb)->cb)
+
+/* @rxq: demuxed frames by priority, received by @napi high first
+ * @csd: schedules @napi from another cpu while @csd_busy
+ */
+struct xeth_mux_rx {
+	struct net_device *mux;
+	struct napi_struct napi;
+	struct sk_buff_head rxq[XETH_VLAN_PRIO_MAX + 1];
+	call_single_data_t csd;
+	atomic_t csd_busy;
+};
+
+/* @link: the lower of each hash bucket; replaced whole under RTNL */
+struct xeth_mux_link_ht {
+	struct rcu_head rcu;
+	struct net_device *link[xeth_mux_link_hash_bkts];
 };
 
 struct xeth_mux_priv {
@@ -31,18 +205,61 @@ struct xeth_mux_priv {
 	struct net_device *nd;
 	struct xeth_nb nb;
 	struct task_struct *main;
-	struct net_device *link[xeth_mux_link_hash_bkts];
+	struct xeth_mux_link_ht __rcu *link_ht;
+	/* @congested: link hash buckets that dropped or marked a frame
+	 * @tx_wake: wakes the @tx_stopped proxies of uncongested buckets
+	 */
+	unsigned long congested;
+	struct timer_list tx_wake;
+	spinlock_t tx_stopped_lock;
+	struct list_head tx_stopped;
 	struct {
 		struct mutex mutex;
 		struct hlist_head __rcu	hls[xeth_mux_proxy_hash_bkts];
 		struct list_head __rcu ports, vlans, bridges, lags, lbs;
+		/* @free_xids: set if available for a port, lag, bridge or lb */
+		DECLARE_BITMAP(free_xids, XETH_VLAN_N_VID);
 	} proxy;
 	atomic64_t counters[xeth_mux_n_counters];
 	atomic64_t link_stats[XETH_N_LINK_STAT];
 	volatile unsigned long flags;
+	/* @carrier_grace: jiffies when stale port carrier is dropped */
+	unsigned long carrier_grace;
+	/* @steer: cpu + 1 to receive the frames of each xid, less any VLAN,
+	 *	or zero for the steer module parameter
+	 */
+	u16 steer[XETH_VLAN_N_VID];
+	/* @ifinfo_dump: epoch of the current or last ifinfo dump
+	 * @ifinfo_list, @ifinfo_cursor: where the dump resumes, after the
+	 *	kin entry of the last proxy reached or at the start of that
+	 *	list if NULL; both are guarded by the proxy mutex
+	 */
+	u32 ifinfo_dump;
+	unsigned int ifinfo_list;
+	struct list_head *ifinfo_cursor;
+	struct xeth_mux_policer ex_policers[xeth_mux_n_ex];
+	/* @devlink: reports the admitted exceptions of each class */
+	struct devlink *devlink;
+	/* @dom_work: samples the port after @dom_xid while admin-up */
+	struct delayed_work dom_work;
+	u32 dom_xid;
+	struct xeth_mux_rx __percpu *rx;
+	/* @xdp_prog: runs on frames received by the mux for the daemon */
+	struct bpf_prog __rcu *xdp_prog;
 	struct {
 		spinlock_t mutex;
 		struct list_head free, tx;
+		/* @queued_sz: allocated size of the tx list */
+		size_t queued_sz;
+		/* @sock: the daemon's connection while serviced */
+		struct socket *sock;
+		/* @journal: ring of the messages numbered through @gen from
+		 *	the free running offsets @jtail to @jhead
+		 * @marked: the @gen of the last GEN message queued
+		 */
+		u8 *journal;
+		u64 jhead, jtail;
+		u64 gen, marked;
 		char rx[XETH_SIZEOF_JUMBO_FRAME];
 	} sb;
 	struct {
@@ -103,6 +320,137 @@ static inline void xeth_mux_unlock_stat_name(struct xeth_mux_priv *priv)
 	mutex_unlock(&priv->stat_name.mutex);
 }
 
+static unsigned long xeth_mux_dom_period(void)
+{
+	unsigned int ms = READ_ONCE(xeth_mux_qsfp_dom_ms);
+	return msecs_to_jiffies(ms ? ms : MSEC_PER_SEC);
+}
+
+/* returns the held port with a module after @dom_xid, wrapping to the first */
+static struct xeth_proxy *xeth_mux_hold_next_dom(struct xeth_mux_priv *priv)
+{
+	struct xeth_proxy *proxy, *first = NULL, *next = NULL;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(proxy, &priv->proxy.ports, kin) {
+		if (proxy->nd->reg_state != NETREG_REGISTERED ||
+		    !xeth_port_has_qsfp(proxy->nd))
+			continue;
+		if (!first || proxy->xid < first->xid)
+			first = proxy;
+		if (proxy->xid > priv->dom_xid &&
+		    (!next || proxy->xid < next->xid))
+			next = proxy;
+	}
+	if (!next)
+		next = first;
+	if (next)
+		dev_hold(next->nd);
+	rcu_read_unlock();
+	return next;
+}
+
+/* Sample a batch of modules each period, round-robin by xid, so the i2c
+ * bandwidth is bounded regardless of the number of ports and ethtool stats
+ * of each are read from the port cache without waiting on the bus.
+ */
+static void xeth_mux_sample_dom(struct work_struct *work)
+{
+	struct xeth_mux_priv *priv =
+		container_of(to_delayed_work(work), struct xeth_mux_priv,
+			     dom_work);
+	struct xeth_proxy *proxy;
+	u32 start = 0;
+	int i;
+
+	for (i = 0; READ_ONCE(xeth_mux_qsfp_dom_ms) && i < xeth_mux_dom_batch;
+	     i++) {
+		proxy = xeth_mux_hold_next_dom(priv);
+		if (!proxy)
+			break;
+		/* fewer modules than a batch */
+		if (i && proxy->xid == start) {
+			dev_put(proxy->nd);
+			break;
+		}
+		if (!i)
+			start = proxy->xid;
+		priv->dom_xid = proxy->xid;
+		xeth_port_sample_dom(proxy->nd);
+		dev_put(proxy->nd);
+	}
+	queue_delayed_work(system_long_wq, &priv->dom_work,
+			   xeth_mux_dom_period());
+}
+
+static int xeth_mux_link_hash_xid(u32 xid)
+{
+	return xid & 1;
+}
+
+/* Call with rcu_read_lock_bh(), as in the transmit path. */
+static struct net_device *xeth_mux_link(struct xeth_mux_priv *priv, int bkt)
+{
+	struct xeth_mux_link_ht *ht = rcu_dereference_bh(priv->link_ht);
+	return ht ? ht->link[bkt] : NULL;
+}
+
+/* A link is congested while any of its tx queues has a qdisc backlog of more
+ * than half its tx_queue_len or, without a qdisc, is stopped.
+ */
+static bool xeth_mux_link_is_congested(struct net_device *link)
+{
+	unsigned int i, limit = READ_ONCE(link->tx_queue_len) / 2;
+
+	for (i = 0; i < link->real_num_tx_queues; i++) {
+		struct netdev_queue *txq = netdev_get_tx_queue(link, i);
+		struct Qdisc *q = rcu_dereference_bh(txq->qdisc);
+
+		if (q->enqueue ? qdisc_qlen_sum(q) > limit :
+		    netif_xmit_stopped(txq))
+			return true;
+	}
+	return false;
+}
+
+static void xeth_mux_congest(struct xeth_mux_priv *priv, int bkt)
+{
+	if (!test_and_set_bit(bkt, &priv->congested))
+		mod_timer(&priv->tx_wake, jiffies + 1);
+}
+
+/* Clear the buckets of drained links, then wake the stopped proxies of all
+ * uncongested buckets; rearm while any remain congested.
+ */
+static void xeth_mux_tx_wake(struct timer_list *t)
+{
+	struct xeth_mux_priv *priv = from_timer(priv, t, tx_wake);
+	struct xeth_proxy *proxy, *tmp;
+	struct net_device *link;
+	int i;
+
+	rcu_read_lock_bh();
+	for (i = 0; i < xeth_mux_link_hash_bkts; i++) {
+		if (!test_bit(i, &priv->congested))
+			continue;
+		link = xeth_mux_link(priv, i);
+		if (!link || !xeth_mux_link_is_congested(link))
+			clear_bit(i, &priv->congested);
+	}
+	smp_mb__after_atomic();
+	spin_lock(&priv->tx_stopped_lock);
+	list_for_each_entry_safe(proxy, tmp, &priv->tx_stopped, tx_stopped)
+		if (!test_bit(xeth_mux_link_hash_xid(proxy->xid),
+			      &priv->congested)) {
+			list_del_init(&proxy->tx_stopped);
+			netif_tx_wake_all_queues(proxy->nd);
+		}
+	spin_unlock(&priv->tx_stopped_lock);
+	rcu_read_unlock_bh();
+	if (READ_ONCE(priv->congested))
+		mod_timer(&priv->tx_wake, jiffies + 1);
+}
+
 static void xeth_mux_priv_init(struct xeth_mux_priv *priv)
 {
 	int i;
@@ -118,10 +466,25 @@ static void xeth_mux_priv_init(struct xeth_mux_priv *priv)
 	INIT_LIST_HEAD_RCU(&priv->proxy.bridges);
 	INIT_LIST_HEAD_RCU(&priv->proxy.lags);
 	INIT_LIST_HEAD_RCU(&priv->proxy.lbs);
+	INIT_DELAYED_WORK(&priv->dom_work, xeth_mux_sample_dom);
+	timer_setup(&priv->tx_wake, xeth_mux_tx_wake, 0);
+	spin_lock_init(&priv->tx_stopped_lock);
+	INIT_LIST_HEAD(&priv->tx_stopped);
+	for (i = 0; i < xeth_mux_n_ex; i++)
+		spin_lock_init(&priv->ex_policers[i].lock);
+	bitmap_fill(priv->proxy.free_xids, XETH_VLAN_N_VID);
+	__clear_bit(0, priv->proxy.free_xids);
+	__clear_bit(XETH_VLAN_N_VID - 1, priv->proxy.free_xids);
 
 	INIT_LIST_HEAD(&priv->sb.free);
 	INIT_LIST_HEAD(&priv->sb.tx);
+	/* base generations on load time so that a switch daemon can't
+	 * resync with one from a previous instance of the mux
+	 */
+	priv->sb.gen = (u64)ktime_get_real_seconds() << 32;
+	priv->sb.marked = priv->sb.gen;
 	INIT_LIST_HEAD(&priv->nb.fibs);
+	mutex_init(&priv->nb.fibs_mutex);
 }
 
 struct xeth_nb *xeth_mux_nb(struct net_device *mux)
@@ -240,6 +603,50 @@ static struct device_attribute xeth_mux_stat_name_attr = {
 	.store = xeth_mux_store_stat_name,
 };
 
+static ssize_t steer_show(struct device *dev, struct device_attribute *attr,
+			  char *buf)
+{
+	struct xeth_mux_priv *priv = netdev_priv(to_net_dev(dev));
+	ssize_t n = 0;
+	u32 xid;
+	u16 cpu;
+
+	for (xid = 0; xid < XETH_VLAN_N_VID; xid++)
+		if ((cpu = READ_ONCE(priv->steer[xid])))
+			n += scnprintf(buf + n, PAGE_SIZE - n, "%u %u\n",
+				       xid, cpu - 1);
+	return n;
+}
+
+/* "XID CPU" steers the frames of that xid and its VLANs; "XID -1" reverts
+ * to the steer module parameter
+ */
+static ssize_t steer_store(struct device *dev, struct device_attribute *attr,
+			   const char *buf, size_t n)
+{
+	struct xeth_mux_priv *priv = netdev_priv(to_net_dev(dev));
+	u32 xid;
+	int cpu;
+
+	if (sscanf(buf, "%u %d", &xid, &cpu) != 2)
+		return -EINVAL;
+	if (xid >= XETH_VLAN_N_VID || cpu < -1 || cpu >= nr_cpu_ids)
+		return -EINVAL;
+	WRITE_ONCE(priv->steer[xid], cpu + 1);
+	return n;
+}
+
+static DEVICE_ATTR_RW(steer);
+
+static struct attribute *xeth_mux_steer_attrs[] = {
+	&dev_attr_steer.attr,
+	NULL,
+};
+
+static const struct attribute_group xeth_mux_steer_group = {
+	.attrs = xeth_mux_steer_attrs,
+};
+
 struct xeth_proxy *xeth_mux_proxy_of_xid(struct net_device *mux, u32 xid)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
@@ -303,13 +710,35 @@ struct xeth_proxy *xeth_mux_proxy_of_nd(struct net_device *mux,
 	return NULL;
 }
 
+bool xeth_mux_has_proxy_in_net(struct net_device *mux, struct net *net,
+			       struct net_device *except)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_proxy *proxy;
+	unsigned bkt;
+
+	rcu_read_lock();
+	for (bkt = 0; bkt < xeth_mux_proxy_hash_bkts; bkt++)
+		hlist_for_each_entry_rcu(proxy, &priv->proxy.hls[bkt], node)
+			if (proxy->nd != except &&
+			    net_eq(dev_net(proxy->nd), net)) {
+				rcu_read_unlock();
+				return true;
+			}
+	rcu_read_unlock();
+	return false;
+}
+
 void xeth_mux_add_proxy(struct xeth_proxy *proxy)
 {
 	struct xeth_mux_priv *priv = netdev_priv(proxy->mux);
+	struct xeth_proxy *link;
 	unsigned bkt;
 
 	bkt = hash_min(proxy->xid, xeth_mux_proxy_hash_bits);
 	xeth_mux_lock_proxy(priv);
+	/* rather than a dump in progress, its REG introduces this */
+	proxy->dumped = READ_ONCE(priv->ifinfo_dump);
 	hlist_add_head_rcu(&proxy->node, &priv->proxy.hls[bkt]);
 	switch (proxy->kind) {
 	case XETH_DEV_KIND_PORT:
@@ -317,6 +746,8 @@ void xeth_mux_add_proxy(struct xeth_proxy *proxy)
 		break;
 	case XETH_DEV_KIND_VLAN:
 		list_add_rcu(&proxy->kin, &priv->proxy.vlans);
+		link = netdev_priv(xeth_vlan_link(proxy->nd));
+		list_add_rcu(&proxy->vlan, &link->vlans);
 		break;
 	case XETH_DEV_KIND_BRIDGE:
 		list_add_rcu(&proxy->kin, &priv->proxy.bridges);
@@ -334,14 +765,77 @@ void xeth_mux_add_proxy(struct xeth_proxy *proxy)
 	xeth_mux_unlock_proxy(priv);
 }
 
-void xeth_mux_del_proxy(struct xeth_proxy *proxy)
+/* returns the highest available port xid or the lowest available xid of the
+ * upper range for other kinds; or, -ENOSPC
+ */
+int xeth_mux_alloc_xid(struct net_device *mux, enum xeth_dev_kind kind)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	unsigned long xid;
+
+	xeth_mux_lock_proxy(priv);
+	if (kind == XETH_DEV_KIND_PORT) {
+		xid = find_last_bit(priv->proxy.free_xids,
+				    xeth_mux_port_xid_max + 1);
+		if (xid > xeth_mux_port_xid_max)
+			xid = 0;
+	} else {
+		xid = find_next_bit(priv->proxy.free_xids,
+				    xeth_mux_upper_xid_max + 1,
+				    xeth_mux_upper_xid_min);
+		if (xid > xeth_mux_upper_xid_max)
+			xid = 0;
+	}
+	if (xid)
+		__clear_bit(xid, priv->proxy.free_xids);
+	xeth_mux_unlock_proxy(priv);
+	return xid ? xid : -ENOSPC;
+}
+
+int xeth_mux_reserve_xid(struct net_device *mux, u32 xid)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	int err = 0;
+
+	if (xid >= XETH_VLAN_N_VID)
+		return -ERANGE;
+	xeth_mux_lock_proxy(priv);
+	if (!__test_and_clear_bit(xid, priv->proxy.free_xids))
+		err = -EBUSY;
+	xeth_mux_unlock_proxy(priv);
+	return err;
+}
+
+/* Unlink the proxy without waiting for RCU readers; this is sufficient
+ * within ndo_uninit since unregister_netdevice_many synchronizes once for
+ * its whole batch before freeing any of them.
+ */
+void xeth_mux_unlink_proxy(struct xeth_proxy *proxy)
 {
 	struct xeth_mux_priv *priv = netdev_priv(proxy->mux);
 
 	xeth_mux_lock_proxy(priv);
-	hlist_del_rcu(&proxy->node);
-	list_del(&proxy->kin);
+	spin_lock_bh(&priv->tx_stopped_lock);
+	list_del_init(&proxy->tx_stopped);
+	spin_unlock_bh(&priv->tx_stopped_lock);
+	/* newlink error paths unlink before unregister and ndo_uninit */
+	if (!hlist_unhashed(&proxy->node)) {
+		/* the previous entry may be the list head, its start */
+		if (priv->ifinfo_cursor == &proxy->kin)
+			priv->ifinfo_cursor = proxy->kin.prev;
+		hlist_del_init_rcu(&proxy->node);
+		list_del_rcu(&proxy->kin);
+		if (proxy->kind == XETH_DEV_KIND_VLAN)
+			list_del_rcu(&proxy->vlan);
+		else if (proxy->xid < XETH_VLAN_N_VID)
+			__set_bit(proxy->xid, priv->proxy.free_xids);
+	}
 	xeth_mux_unlock_proxy(priv);
+}
+
+void xeth_mux_del_proxy(struct xeth_proxy *proxy)
+{
+	xeth_mux_unlink_proxy(proxy);
 	synchronize_rcu();
 }
 
@@ -365,31 +859,93 @@ static void xeth_mux_reset_all_link_stats(struct net_device *mux)
 	rcu_read_unlock();
 }
 
+void xeth_mux_reset_all_stats(struct net_device *mux)
+{
+	xeth_mux_reset_all_link_stats(mux);
+	xeth_mux_reset_all_port_ethtool_stats(mux);
+}
+
 void xeth_mux_change_carrier(struct net_device *mux, struct net_device *nd,
 			     bool on)
 {
-	struct xeth_mux_priv *priv = netdev_priv(mux);
 	void (*change_carrier)(struct net_device *dev) =
 		on ? netif_carrier_on : netif_carrier_off;
+	struct xeth_proxy *link = netdev_priv(nd);
 	struct xeth_proxy *proxy;
 
 	change_carrier(nd);
 	rcu_read_lock();
-	list_for_each_entry_rcu(proxy, &priv->proxy.vlans, kin)
-		if (xeth_vlan_has_link(proxy->nd, nd))
-			change_carrier(proxy->nd);
+	list_for_each_entry_rcu(proxy, &link->vlans, vlan)
+		change_carrier(proxy->nd);
 	rcu_read_unlock();
 }
 
+static bool xeth_mux_lower_is_oper(struct net_device *lower)
+{
+	return netif_running(lower) && netif_carrier_ok(lower);
+}
+
+/* Spread the hash buckets over the operational lowers so that losing one of
+ * n links costs 1/n of the capacity rather than blackholing its buckets;
+ * with none operational, keep all lowers to count their heartbeat errors.
+ * Call with RTNL.
+ */
+static void xeth_mux_rehash_link_ht(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct net_device *ups[xeth_mux_link_hash_bkts];
+	struct xeth_mux_link_ht *ht, *old;
+	struct net_device *lower;
+	struct list_head *lowers;
+	int i, n = 0;
+
+	netdev_for_each_lower_dev(mux, lower, lowers)
+		if (n < xeth_mux_link_hash_bkts &&
+		    xeth_mux_lower_is_oper(lower))
+			ups[n++] = lower;
+	if (!n)
+		netdev_for_each_lower_dev(mux, lower, lowers)
+			if (n < xeth_mux_link_hash_bkts)
+				ups[n++] = lower;
+	old = rtnl_dereference(priv->link_ht);
+	if (!n) {
+		if (!old)
+			return;
+		ht = NULL;
+	} else {
+		if (old) {
+			for (i = 0; i < xeth_mux_link_hash_bkts; i++)
+				if (old->link[i] != ups[i % n])
+					break;
+			if (i == xeth_mux_link_hash_bkts)
+				return;
+		}
+		ht = kmalloc(sizeof(*ht), GFP_KERNEL);
+		if (!ht) {
+			xeth_nd_err(mux, "no mem for link hash table");
+			return;
+		}
+		for (i = 0; i < xeth_mux_link_hash_bkts; i++)
+			ht->link[i] = ups[i % n];
+	}
+	rcu_assign_pointer(priv->link_ht, ht);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
 void xeth_mux_check_lower_carrier(struct net_device *mux)
 {
 	struct net_device *lower;
 	struct list_head *lowers;
 	bool carrier = true;
 
-	netdev_for_each_lower_dev(mux, lower, lowers)
-		if (!netif_carrier_ok(lower))
-			carrier = false;
+	xeth_mux_rehash_link_ht(mux);
+	/* without lowers, the mux is switch-less and always has carrier */
+	netdev_for_each_lower_dev(mux, lower, lowers) {
+		carrier = xeth_mux_lower_is_oper(lower);
+		if (carrier)
+			break;
+	}
 	if (carrier) {
 		if (!netif_carrier_ok(mux))
 			netif_carrier_on(mux);
@@ -400,46 +956,151 @@ void xeth_mux_check_lower_carrier(struct net_device *mux)
 void xeth_mux_del_vlans(struct net_device *mux, struct net_device *nd,
 			struct list_head *unregq)
 {
-	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_proxy *link = netdev_priv(nd);
 	struct xeth_proxy *proxy;
 
 	rcu_read_lock();
-	list_for_each_entry_rcu(proxy, &priv->proxy.vlans, kin)
-		if (xeth_vlan_has_link(proxy->nd, nd))
-			unregister_netdevice_queue(proxy->nd, unregq);
+	list_for_each_entry_rcu(proxy, &link->vlans, vlan)
+		unregister_netdevice_queue(proxy->nd, unregq);
 	rcu_read_unlock();
 }
 
+/* Begin a new ifinfo dump epoch that the mux thread sends in chunks between
+ * servicing the sideband.
+ */
 void xeth_mux_dump_all_ifinfo(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+
+	xeth_mux_lock_proxy(priv);
+	xeth_mux_lock_sb(priv);
+	priv->ifinfo_dump++;
+	xeth_mux_unlock_sb(priv);
+	priv->ifinfo_list = 0;
+	priv->ifinfo_cursor = NULL;
+	xeth_mux_unlock_proxy(priv);
+	xeth_mux_set_sb_ifinfo_dump(mux);
+}
+
+/* Dump the next chunk of proxies that haven't been reached in this epoch;
+ * returns false after all have been dumped.
+ *
+ * Each chunk resumes after the last proxy reached by the previous one rather
+ * than rewalk the lists; xeth_mux_add_proxy() marks those added since as
+ * reached because their REG and later updates already follow. The proxies
+ * are held rather than dumped within the proxy lock since that sleeps to
+ * allocate.
+ */
+static bool xeth_mux_dump_ifinfo_chunk(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct list_head *lists[] = {
+		&priv->proxy.lbs,
+		&priv->proxy.ports,
+		&priv->proxy.lags,
+		&priv->proxy.vlans,
+		&priv->proxy.bridges,
+	};
+	struct xeth_proxy *proxy, *chunk[xeth_mux_ifinfo_dump_chunk];
+	struct list_head *head;
+	int i, n = 0;
+
+	xeth_mux_lock_proxy(priv);
+	for (; priv->ifinfo_list < ARRAY_SIZE(lists);
+	     priv->ifinfo_list++, priv->ifinfo_cursor = NULL) {
+		head = lists[priv->ifinfo_list];
+		proxy = list_entry(priv->ifinfo_cursor ?
+				   priv->ifinfo_cursor : head,
+				   struct xeth_proxy, kin);
+		list_for_each_entry_continue(proxy, head, kin) {
+			if (n == ARRAY_SIZE(chunk))
+				goto held;
+			priv->ifinfo_cursor = &proxy->kin;
+			if (proxy->dumped == priv->ifinfo_dump)
+				continue;
+			dev_hold(proxy->nd);
+			chunk[n++] = proxy;
+		}
+	}
+held:
+	xeth_mux_unlock_proxy(priv);
+	xeth_mux_set_sb_dumping(mux);
+	for (i = 0; i < n; i++) {
+		xeth_proxy_dump_ifinfo(chunk[i]);
+		/* also mark those without an xid to make progress */
+		chunk[i]->dumped = priv->ifinfo_dump;
+		dev_put(chunk[i]->nd);
+	}
+	xeth_mux_clear_sb_dumping(mux);
+	return n > 0;
+}
+
+static void xeth_mux_drop_all_port_carrier(struct net_device *mux)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	struct xeth_proxy *proxy;
 
 	rcu_read_lock();
-	list_for_each_entry_rcu(proxy, &priv->proxy.lbs, kin)
-		xeth_proxy_dump_ifinfo(proxy);
 	list_for_each_entry_rcu(proxy, &priv->proxy.ports, kin)
-		xeth_proxy_dump_ifinfo(proxy);
-	list_for_each_entry_rcu(proxy, &priv->proxy.lags, kin)
-		xeth_proxy_dump_ifinfo(proxy);
-	list_for_each_entry_rcu(proxy, &priv->proxy.vlans, kin)
-		xeth_proxy_dump_ifinfo(proxy);
-	list_for_each_entry_rcu(proxy, &priv->proxy.bridges, kin)
-		xeth_proxy_dump_ifinfo(proxy);
+		netif_carrier_off(proxy->nd);
 	rcu_read_unlock();
 }
 
-static void xeth_mux_drop_all_port_carrier(struct net_device *mux)
+static void xeth_mux_drop_stale_port_carrier(struct net_device *mux)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	struct xeth_proxy *proxy;
 
 	rcu_read_lock();
 	list_for_each_entry_rcu(proxy, &priv->proxy.ports, kin)
-		netif_carrier_off(proxy->nd);
+		if (xeth_port_carrier_stale(proxy->nd)) {
+			xeth_port_set_carrier_stale(proxy->nd, false);
+			netif_carrier_off(proxy->nd);
+		}
 	rcu_read_unlock();
 }
 
+/* Rather than drop carrier on disconnect, keep it for the grace period to
+ * ride through a switch daemon restart.
+ */
+static void xeth_mux_begin_carrier_grace(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_proxy *proxy;
+
+	if (!xeth_mux_carrier_grace_ms) {
+		xeth_mux_drop_all_port_carrier(mux);
+		return;
+	}
+	rcu_read_lock();
+	list_for_each_entry_rcu(proxy, &priv->proxy.ports, kin)
+		xeth_port_set_carrier_stale(proxy->nd, true);
+	rcu_read_unlock();
+	priv->carrier_grace = jiffies +
+		msecs_to_jiffies(xeth_mux_carrier_grace_ms);
+	xeth_mux_set_sb_grace(mux);
+}
+
+static void xeth_mux_check_carrier_grace(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+
+	if (xeth_mux_has_sb_grace(mux) &&
+	    time_after(jiffies, priv->carrier_grace))
+		xeth_mux_reconcile(mux);
+}
+
+/* The switch daemon confirms that it has refreshed each port carrier with
+ * a BREAK; so drop the carrier of the ports that it didn't.
+ */
+void xeth_mux_reconcile(struct net_device *mux)
+{
+	if (xeth_mux_has_sb_grace(mux)) {
+		xeth_mux_drop_stale_port_carrier(mux);
+		xeth_mux_clear_sb_grace(mux);
+	}
+}
+
 static void xeth_mux_reset_all_port_ethtool_stats(struct net_device *mux)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
@@ -466,6 +1127,7 @@ volatile unsigned long *xeth_mux_flags(struct net_device *mux)
 static const struct ethtool_ops xeth_mux_ethtool_ops;
 static rx_handler_result_t xeth_mux_demux(struct sk_buff **pskb);
 static void xeth_mux_demux_vlan(struct net_device *mux, struct sk_buff *skb);
+static void xeth_mux_demux_trap(struct net_device *mux, struct sk_buff *skb);
 
 static void xeth_mux_setup(struct net_device *mux)
 {
@@ -475,6 +1137,7 @@ static void xeth_mux_setup(struct net_device *mux)
 	mux->ethtool_ops = &xeth_mux_ethtool_ops;
 	mux->needs_free_netdev = true;
 	mux->priv_destructor = NULL;
+	mux->sysfs_groups[0] = &xeth_mux_steer_group;
 	ether_setup(mux);
 	mux->flags |= IFF_MASTER;
 	mux->priv_flags |= IFF_DONT_BRIDGE;
@@ -483,6 +1146,10 @@ static void xeth_mux_setup(struct net_device *mux)
 	mux->min_mtu = ETH_MIN_MTU;
 	mux->max_mtu = ETH_MAX_MTU - VLAN_HLEN;
 	mux->mtu = XETH_SIZEOF_JUMBO_FRAME - VLAN_HLEN;
+#ifdef xeth_mux_xdp_features
+	mux->xdp_features = NETDEV_XDP_ACT_BASIC | NETDEV_XDP_ACT_REDIRECT |
+		NETDEV_XDP_ACT_NDO_XMIT;
+#endif
 
 	xeth_mux_priv_init(priv);
 
@@ -524,20 +1191,6 @@ static int xeth_mux_handle_lower(struct net_device *mux,
 	return netdev_rx_handler_register(lower, xeth_mux_demux, mux);
 }
 
-static void xeth_mux_rehash_link_ht(struct net_device *mux)
-{
-	struct xeth_mux_priv *priv = netdev_priv(mux);
-	struct net_device *lower;
-	struct list_head *lowers;
-	int i, n = 1;
-
-	netdev_for_each_lower_dev(mux, lower, lowers) {
-		for (i = n - 1; i < xeth_mux_link_hash_bkts; i += n)
-			priv->link[i] = lower;
-		n++;
-	}
-}
-
 static int xeth_mux_bind_lower(struct net_device *mux,
 			       struct net_device *lower,
 			       struct netlink_ext_ack *ack)
@@ -581,6 +1234,7 @@ static int xeth_mux_del_lower(struct net_device *mux, struct net_device *lower)
 {
 	lower->flags &= ~IFF_SLAVE;
 	netdev_upper_dev_unlink(lower, mux);
+	xeth_mux_rehash_link_ht(mux);
 	netdev_rx_handler_unregister(lower);
 	dev_set_promiscuity(lower, -1);
 	dev_put(lower);
@@ -596,7 +1250,7 @@ static int xeth_mux_validate(struct nlattr *tb[], struct nlattr *data[],
 	}
 	if (data && data[XETH_MUX_IFLA_ENCAP]) {
 		u8 val = nla_get_u8(data[XETH_MUX_IFLA_ENCAP]);
-		if (val > XETH_ENCAP_VPLS) {
+		if (val > XETH_ENCAP_TRAP) {
 			xeth_debug("invalid encap %u", val);
 			NL_SET_ERR_MSG(ack, "invalid encap");
 			return -ERANGE;
@@ -629,17 +1283,6 @@ struct xeth_sbtxb *xeth_mux_alloc_sbtxb(struct net_device *mux, size_t len)
 	return sbtxb;
 }
 
-static void xeth_mux_append_sbtxb(struct net_device *mux,
-				  struct xeth_sbtxb *sbtxb)
-{
-	struct xeth_mux_priv *priv = netdev_priv(mux);
-
-	xeth_mux_lock_sb(priv);
-	list_add_tail(&sbtxb->list, &priv->sb.tx);
-	xeth_mux_unlock_sb(priv);
-	xeth_mux_inc_sbtx_queued(mux);
-}
-
 static void xeth_mux_prepend_sbtxb(struct net_device *mux,
 				   struct xeth_sbtxb *sbtxb)
 {
@@ -647,6 +1290,7 @@ static void xeth_mux_prepend_sbtxb(struct net_device *mux,
 
 	xeth_mux_lock_sb(priv);
 	list_add(&sbtxb->list, &priv->sb.tx);
+	priv->sb.queued_sz += sbtxb->sz;
 	xeth_mux_unlock_sb(priv);
 	xeth_mux_inc_sbtx_queued(mux);
 }
@@ -661,6 +1305,7 @@ static struct xeth_sbtxb *xeth_mux_pop_sbtxb(struct net_device *mux)
 					 struct xeth_sbtxb, list);
 	if (sbtxb) {
 		list_del(&sbtxb->list);
+		priv->sb.queued_sz -= sbtxb->sz;
 		xeth_mux_dec_sbtx_queued(mux);
 	}
 	xeth_mux_unlock_sb(priv);
@@ -678,12 +1323,368 @@ static void xeth_mux_free_sbtxb(struct net_device *mux,
 	xeth_mux_inc_sbtx_free(mux);
 }
 
-void xeth_mux_queue_sbtx(struct net_device *mux, struct xeth_sbtxb *sbtxb)
+static bool xeth_mux_is_journaled(struct xeth_msg_header *header)
+{
+	switch (header->kind) {
+	case XETH_MSG_KIND_BREAK:
+	case XETH_MSG_KIND_GEN:
+	case XETH_MSG_KIND_RESYNC:
+	case XETH_MSG_KIND_DUMP_REQUIRED:
+		return false;
+	}
+	return true;
+}
+
+static bool xeth_mux_is_fibinfo(struct xeth_msg_header *header)
+{
+	switch (header->kind) {
+	case XETH_MSG_KIND_FIBENTRY:
+	case XETH_MSG_KIND_FIB6ENTRY:
+	case XETH_MSG_KIND_FIBENTRY_COMPACT:
+	case XETH_MSG_KIND_FIB6ENTRY_COMPACT:
+	case XETH_MSG_KIND_FIB_FLUSH:
+	case XETH_MSG_KIND_FIB_FLUSH_DEV:
+	case XETH_MSG_KIND_NEIGH_UPDATE:
+	case XETH_MSG_KIND_NEIGH_UPDATE_COMPACT:
+	case XETH_MSG_KIND_NETNS_ADD:
+	case XETH_MSG_KIND_NETNS_DEL:
+	case XETH_MSG_KIND_NEXTHOP:
+	case XETH_MSG_KIND_NEXTHOP_GROUP:
+		return true;
+	}
+	return false;
+}
+
+/* must hold sb lock; returns true if @header is an update of a proxy that
+ * the current ifinfo dump hasn't reached. Such an update would precede the
+ * proxy's IFINFO so it's dropped in favor of the subsequent dump.
+ *
+ * The IFINFO DUMP of a proxy marks it as reached within the same critical
+ * section that queues it so that no later update is lost.
+ */
+static bool xeth_mux_is_undumped(struct net_device *mux,
+				 struct xeth_msg_header *header)
 {
-	if (xeth_mux_has_sb_connection(mux))
-		xeth_mux_append_sbtxb(mux, sbtxb);
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_msg_ifinfo *ifinfo = (struct xeth_msg_ifinfo *)header;
+	struct xeth_proxy *proxy;
+	bool undumped = false;
+	u32 xid;
+
+	switch (header->kind) {
+	case XETH_MSG_KIND_IFINFO:
+	case XETH_MSG_KIND_IFA:
+	case XETH_MSG_KIND_IFA6:
+	case XETH_MSG_KIND_ETHTOOL_FLAGS:
+	case XETH_MSG_KIND_ETHTOOL_SETTINGS:
+	case XETH_MSG_KIND_ETHTOOL_LINK_MODES_SUPPORTED:
+	case XETH_MSG_KIND_ETHTOOL_LINK_MODES_ADVERTISING:
+	case XETH_MSG_KIND_ETHTOOL_LINK_MODES_LP_ADVERTISING:
+	case XETH_MSG_KIND_CHANGE_UPPER_XID:
+		break;
+	default:
+		return false;
+	}
+	/* each of these has the xid, or upper xid, following the header */
+	xid = *(u32 *)(header + 1);
+	rcu_read_lock();
+	proxy = xeth_mux_proxy_of_xid(mux, xid);
+	if (proxy) {
+		if (header->kind == XETH_MSG_KIND_IFINFO &&
+		    ifinfo->reason == XETH_IFINFO_REASON_DUMP)
+			proxy->dumped = priv->ifinfo_dump;
+		else if (xeth_mux_has_sb_ifinfo_dump(mux))
+			undumped = proxy->dumped != priv->ifinfo_dump;
+	}
+	rcu_read_unlock();
+	return undumped;
+}
+
+static bool xeth_mux_sbtx_is_full(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+
+	return xeth_mux_get_sbtx_queued(mux) >= xeth_mux_sbtx_max_queued ||
+		READ_ONCE(priv->sb.queued_sz) >=
+		(size_t)xeth_mux_sbtx_max_kib << 10;
+}
+
+/* must hold sb lock; returns false if @sbtxb should be dropped.
+ *
+ * Once the tx queue exceeds its depth or size limit, drop the updates of
+ * each class until the switch daemon requests its dump. The first dropped
+ * update of each class is rewritten to DUMP_REQUIRED.
+ *
+ * Dumps by the mux thread are admitted past the limits; instead, the thread
+ * yields to send the queue between dump chunks and netns.
+ */
+static bool xeth_mux_admit_sbtxb(struct net_device *mux,
+				 struct xeth_sbtxb *sbtxb)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_msg_header *header = xeth_sbtxb_data(sbtxb);
+	bool fibinfo, dirty;
+
+	if (xeth_mux_is_undumped(mux, header))
+		return false;
+	if (!xeth_mux_is_journaled(header))
+		return true;
+	if (xeth_mux_has_sb_dumping(mux) && current == priv->main)
+		return true;
+	fibinfo = xeth_mux_is_fibinfo(header);
+	dirty = fibinfo ? xeth_mux_has_sb_fibinfo_dirty(mux) :
+		xeth_mux_has_sb_ifinfo_dirty(mux);
+	if (!dirty &&
+	    xeth_mux_get_sbtx_queued(mux) < xeth_mux_sbtx_max_queued &&
+	    priv->sb.queued_sz + sbtxb->sz <=
+	    (size_t)xeth_mux_sbtx_max_kib << 10)
+		return true;
+	xeth_mux_inc_sbtx_overflows(mux);
+	if (dirty)
+		return false;
+	if (fibinfo)
+		xeth_mux_set_sb_fibinfo_dirty(mux);
 	else
-		xeth_mux_free_sbtxb(mux, sbtxb);
+		xeth_mux_set_sb_ifinfo_dirty(mux);
+	/* a later GEN would include the dropped updates; rearm after the
+	 * respective dump
+	 */
+	if (xeth_mux_has_sb_gen(mux)) {
+		xeth_mux_clear_sb_gen(mux);
+		xeth_mux_set_sb_regen(mux);
+	}
+	xeth_sbtx_dump_required(sbtxb, fibinfo ?
+				BIT(XETH_MSG_DUMP_FIBINFO_BIT) :
+				BIT(XETH_MSG_DUMP_IFINFO_BIT));
+	return true;
+}
+
+static size_t xeth_mux_journaled_size(u64 len)
+{
+	return ALIGN(sizeof(struct xeth_mux_journaled) + len, 8);
+}
+
+/* must hold sb lock */
+static void xeth_mux_journal_write(struct xeth_mux_priv *priv, u64 pos,
+				   const void *buf, size_t n)
+{
+	size_t i = pos & (xeth_mux_journal_sz - 1);
+	size_t m = min_t(size_t, n, xeth_mux_journal_sz - i);
+
+	memcpy(priv->sb.journal + i, buf, m);
+	memcpy(priv->sb.journal, buf + m, n - m);
+}
+
+/* must hold sb lock */
+static void xeth_mux_journal_read(struct xeth_mux_priv *priv, u64 pos,
+				  void *buf, size_t n)
+{
+	size_t i = pos & (xeth_mux_journal_sz - 1);
+	size_t m = min_t(size_t, n, xeth_mux_journal_sz - i);
+
+	memcpy(buf, priv->sb.journal + i, m);
+	memcpy(buf + m, priv->sb.journal, n - m);
+}
+
+/**
+ * xeth_mux_flush_journal() - forget the journaled messages
+ *
+ * Dumps aren't journaled so the fib notifier restart of DUMP_FIBINFO flushes
+ * the journal for a resync from before it to fall back to the full dumps.
+ * This also skips a generation so that a resync from the last can't succeed.
+ */
+void xeth_mux_flush_journal(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+
+	xeth_mux_lock_sb(priv);
+	priv->sb.jtail = priv->sb.jhead;
+	priv->sb.gen++;
+	xeth_mux_unlock_sb(priv);
+}
+
+/* must hold sb lock; returns true if journaled, evicting the oldest
+ * messages for room
+ */
+static bool xeth_mux_journal_sbtxb(struct net_device *mux,
+				   struct xeth_sbtxb *sbtxb)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_mux_journaled j;
+	void *data = xeth_sbtxb_data(sbtxb);
+	size_t sz = xeth_mux_journaled_size(sbtxb->len);
+
+	if (!priv->sb.journal || !xeth_mux_is_journaled(data))
+		return false;
+	while (priv->sb.jhead + sz - priv->sb.jtail > xeth_mux_journal_sz) {
+		xeth_mux_journal_read(priv, priv->sb.jtail, &j, sizeof(j));
+		priv->sb.jtail += xeth_mux_journaled_size(j.len);
+	}
+	j.gen = ++priv->sb.gen;
+	j.len = sbtxb->len;
+	xeth_mux_journal_write(priv, priv->sb.jhead, &j, sizeof(j));
+	xeth_mux_journal_write(priv, priv->sb.jhead + sizeof(j), data,
+			       sbtxb->len);
+	priv->sb.jhead += sz;
+	return true;
+}
+
+/* Journal and queue @sbtxb within the same critical section so that the
+ * generation marked after emptying the queue accounts for all sent messages.
+ * Changes are journaled while disconnected for a subsequent RESYNC but the
+ * dumps of the mux thread aren't. During a resync, the replay rather than
+ * this sends the journaled messages to keep their order.
+ */
+void xeth_mux_queue_sbtx(struct net_device *mux, struct xeth_sbtxb *sbtxb)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	bool journaled = false, queued;
+
+	xeth_mux_lock_sb(priv);
+	if (xeth_mux_has_main_task(mux) &&
+	    !(current == priv->main && xeth_mux_has_sb_dumping(mux)))
+		journaled = xeth_mux_journal_sbtxb(mux, sbtxb);
+	queued = xeth_mux_has_sb_connection(mux) &&
+		!(journaled && xeth_mux_has_sb_resync(mux)) &&
+		xeth_mux_admit_sbtxb(mux, sbtxb);
+	if (queued) {
+		list_add_tail(&sbtxb->list, &priv->sb.tx);
+		priv->sb.queued_sz += sbtxb->sz;
+		xeth_mux_inc_sbtx_queued(mux);
+	} else {
+		list_add_tail(&sbtxb->list, &priv->sb.free);
+		xeth_mux_inc_sbtx_free(mux);
+	}
+	xeth_mux_unlock_sb(priv);
+}
+
+/* must hold sb lock */
+static struct xeth_sbtxb *xeth_mux_alloc_atomic_sbtxb(struct net_device *mux,
+						      size_t len)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_sbtxb *sbtxb;
+	size_t sz;
+
+	list_for_each_entry(sbtxb, &priv->sb.free, list)
+		if (sbtxb->sz >= len) {
+			list_del(&sbtxb->list);
+			xeth_mux_dec_sbtx_free(mux);
+			sbtxb->len = len;
+			return sbtxb;
+		}
+	sz = ALIGN(xeth_sbtxb_size + len, 1024);
+	sbtxb = devm_kzalloc(&mux->dev, sz, GFP_ATOMIC);
+	if (sbtxb) {
+		sbtxb->len = len;
+		sbtxb->sz = sz - xeth_sbtxb_size;
+	}
+	return sbtxb;
+}
+
+/* Replay journaled messages after @gen followed by BREAK if the journal
+ * still has all of them; otherwise reply RESYNC with gen 0 to have the
+ * switch daemon dump everything.
+ *
+ * The sb lock is only held to copy each message so the replay chases the
+ * journal head while sb_resync holds back the newly journaled.
+ */
+void xeth_mux_resync(struct net_device *mux, u64 gen)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_mux_journaled j;
+	struct xeth_sbtxb *sbtxb;
+	bool replay = false;
+	u64 pos;
+
+	xeth_mux_lock_sb(priv);
+	pos = priv->sb.jtail;
+	if (gen == priv->sb.gen) {
+		pos = priv->sb.jhead;
+		replay = true;
+	} else if (gen < priv->sb.gen && pos != priv->sb.jhead) {
+		xeth_mux_journal_read(priv, pos, &j, sizeof(j));
+		replay = j.gen <= gen + 1;
+	}
+	if (replay)
+		xeth_mux_set_sb_resync(mux);
+	xeth_mux_unlock_sb(priv);
+	while (replay) {
+		xeth_mux_lock_sb(priv);
+		if (pos == priv->sb.jhead) {
+			xeth_mux_clear_sb_resync(mux);
+			xeth_mux_unlock_sb(priv);
+			break;
+		}
+		replay = pos - priv->sb.jtail < xeth_mux_journal_sz;
+		if (replay)
+			xeth_mux_journal_read(priv, pos, &j, sizeof(j));
+		xeth_mux_unlock_sb(priv);
+		if (!replay)
+			break;
+		if (j.gen <= gen) {
+			pos += xeth_mux_journaled_size(j.len);
+			continue;
+		}
+		sbtxb = xeth_mux_alloc_sbtxb(mux, j.len);
+		xeth_mux_lock_sb(priv);
+		/* evicted while unlocked */
+		replay = pos - priv->sb.jtail < xeth_mux_journal_sz;
+		if (replay) {
+			xeth_mux_journal_read(priv, pos + sizeof(j),
+					      xeth_sbtxb_data(sbtxb), j.len);
+			list_add_tail(&sbtxb->list, &priv->sb.tx);
+			priv->sb.queued_sz += sbtxb->sz;
+			xeth_mux_inc_sbtx_queued(mux);
+		} else {
+			list_add_tail(&sbtxb->list, &priv->sb.free);
+			xeth_mux_inc_sbtx_free(mux);
+		}
+		xeth_mux_unlock_sb(priv);
+		pos += xeth_mux_journaled_size(j.len);
+	}
+	if (replay) {
+		xeth_mux_inc_sbtx_resyncs(mux);
+		xeth_sbtx_break(mux);
+		xeth_mux_synced(mux);
+	} else {
+		xeth_mux_clear_sb_resync(mux);
+		xeth_sbtx_gen(mux, XETH_MSG_KIND_RESYNC, 0);
+	}
+}
+
+/* Begin marking generations after the switch daemon has a complete view
+ * through either DUMP_FIBINFO or RESYNC.
+ */
+void xeth_mux_synced(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+
+	xeth_mux_lock_sb(priv);
+	priv->sb.marked = priv->sb.gen - 1;
+	xeth_mux_unlock_sb(priv);
+	xeth_mux_clear_sb_regen(mux);
+	xeth_mux_set_sb_gen(mux);
+}
+
+/* returns true with the generation to mark if synced and the tx queue has
+ * emptied since the last mark.
+ */
+static bool xeth_mux_mark_gen(struct net_device *mux, u64 *gen)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	bool mark;
+
+	if (!xeth_mux_has_sb_gen(mux) ||
+	    xeth_mux_has_sb_ifinfo_dirty(mux) ||
+	    xeth_mux_has_sb_fibinfo_dirty(mux))
+		return false;
+	xeth_mux_lock_sb(priv);
+	mark = list_empty(&priv->sb.tx) && priv->sb.marked != priv->sb.gen;
+	if (mark)
+		*gen = priv->sb.marked = priv->sb.gen;
+	xeth_mux_unlock_sb(priv);
+	return mark;
 }
 
 static struct net *xeth_mux_net_of_inum(u64 inum)
@@ -705,7 +1706,7 @@ static int xeth_mux_sbtx(struct net_device *mux, struct socket *sock,
 	struct msghdr msg = {
 		.msg_flags = MSG_DONTWAIT,
 	};
-	struct xeth_msg_netns *ns_msg = iov.iov_base;
+	struct xeth_msg_ifinfo *ifinfo_msg = iov.iov_base;
 	struct net *net;
 	int n;
 
@@ -715,10 +1716,11 @@ static int xeth_mux_sbtx(struct net_device *mux, struct socket *sock,
 		xeth_mux_inc_sbtx_retries(mux);
 		return n;
 	}
-	if (ns_msg->header.kind == XETH_MSG_KIND_NETNS_ADD) {
-		net = xeth_mux_net_of_inum(ns_msg->net);
+	if (ifinfo_msg->header.kind == XETH_MSG_KIND_IFINFO &&
+	    ifinfo_msg->reason == XETH_IFINFO_REASON_REG) {
+		net = xeth_mux_net_of_inum(ifinfo_msg->net);
 		if (net)
-			xeth_nd_prif_err(mux, xeth_nb_start_new_fib(mux, net));
+			xeth_nd_prif_err(mux, xeth_nb_start_net_fib(mux, net));
 	}
 	xeth_mux_free_sbtxb(mux, sbtxb);
 	if (n > 0) {
@@ -728,6 +1730,31 @@ static int xeth_mux_sbtx(struct net_device *mux, struct socket *sock,
 	return n < 0 ? n : 1; /* 1 indicates EOF */
 }
 
+/* The mux thread calls this between the parts of a dump that it can't chunk
+ * like the ifinfo dump, e.g. the fib of each netns, to send the queue until
+ * it's back within its limits.
+ */
+void xeth_mux_yield_sbtx(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_sbtxb *sbtxb;
+	int err;
+
+	if (!priv->sb.sock || current != priv->main)
+		return;
+	while (xeth_mux_sbtx_is_full(mux) &&
+	       !kthread_should_stop() && !signal_pending(current)) {
+		sbtxb = xeth_mux_pop_sbtxb(mux);
+		if (!sbtxb)
+			break;
+		err = xeth_mux_sbtx(mux, priv->sb.sock, sbtxb);
+		if (err == -EAGAIN)
+			msleep_interruptible(10);
+		else if (err)
+			break;
+	}
+}
+
 /* returns < 0 if error, 0 if timeout with nothing read, 1 if sock closed,
  * and >1 othewise
  */
@@ -767,9 +1794,12 @@ static int xeth_mux_service_sb(struct net_device *mux, struct socket *sock)
 	unsigned int ms = minms;
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	struct xeth_sbtxb *sbtxb, *tmp;
+	u64 gen;
 	int err = 0;
 
+	priv->sb.sock = sock;
 	while (!kthread_should_stop() && !signal_pending(current)) {
+		xeth_mux_check_carrier_grace(mux);
 		xeth_mux_inc_sbrx_ticks(mux);
 		err = xeth_mux_sbrx(mux, sock);
 		if (err == 1) {
@@ -779,6 +1809,21 @@ static int xeth_mux_service_sb(struct net_device *mux, struct socket *sock)
 			break;
 		else if (err > 0)
 			ms = minms;
+		/* yield to live updates and carrier between dump chunks */
+		if (xeth_mux_has_sb_ifinfo_dump(mux) &&
+		    xeth_mux_get_sbtx_queued(mux) < xeth_mux_ifinfo_dump_chunk &&
+		    !xeth_mux_sbtx_is_full(mux)) {
+			ms = minms;
+			if (!xeth_mux_dump_ifinfo_chunk(mux)) {
+				xeth_mux_clear_sb_ifinfo_dump(mux);
+				xeth_sbtx_break(mux);
+				/* this dump recovered an ifinfo overflow */
+				if (xeth_mux_has_sb_regen(mux) &&
+				    !xeth_mux_has_sb_ifinfo_dirty(mux) &&
+				    !xeth_mux_has_sb_fibinfo_dirty(mux))
+					xeth_mux_synced(mux);
+			}
+		}
 		sbtxb = xeth_mux_pop_sbtxb(mux);
 		if (sbtxb) {
 			ms = minms;
@@ -791,6 +1836,11 @@ static int xeth_mux_service_sb(struct net_device *mux, struct socket *sock)
 				err = 0;
 				break;
 			}
+		} else if (xeth_mux_mark_gen(mux, &gen)) {
+			ms = minms;
+			xeth_nd_prif_err(mux,
+					 xeth_sbtx_gen(mux, XETH_MSG_KIND_GEN,
+						       gen));
 		} else if (err == 0) {
 			msleep_interruptible(ms);
 			if (ms < maxms)
@@ -798,11 +1848,7 @@ static int xeth_mux_service_sb(struct net_device *mux, struct socket *sock)
 		}
 	}
 
-	xeth_nb_stop_netevent(mux);
-	xeth_nb_stop_all_fib(mux);
-	xeth_nb_stop_inetaddr(mux);
-	xeth_nb_stop_netdevice(mux);
-
+	priv->sb.sock = NULL;
 	xeth_mux_lock_sb(priv);
 	list_for_each_entry_safe(sbtxb, tmp, &priv->sb.tx, list) {
 		list_del(&sbtxb->list);
@@ -810,6 +1856,7 @@ static int xeth_mux_service_sb(struct net_device *mux, struct socket *sock)
 		list_add_tail(&sbtxb->list, &priv->sb.free);
 		xeth_mux_inc_sbtx_free(mux);
 	}
+	priv->sb.queued_sz = 0;
 	xeth_mux_unlock_sb(priv);
 	xeth_prif_err(xeth_mux_get_sbtx_queued(mux) > 0);
 
@@ -819,6 +1866,10 @@ static int xeth_mux_service_sb(struct net_device *mux, struct socket *sock)
 static int xeth_mux_main_exit(struct net_device *mux, struct socket *ln,
 			      int err)
 {
+	xeth_nb_stop_netevent(mux);
+	xeth_nb_stop_all_fib(mux);
+	xeth_nb_stop_inetaddr(mux);
+	xeth_nb_stop_netdevice(mux);
 	if (ln) {
 		sock_release(ln);
 		xeth_mux_clear_sb_listen(mux);
@@ -863,6 +1914,7 @@ static int xeth_mux_main(void *v)
 	for (conn = NULL;
 	     !err && !kthread_should_stop() && !signal_pending(current);
 	     conn = NULL) {
+		xeth_mux_check_carrier_grace(mux);
 		err = kernel_accept(ln, &conn, O_NONBLOCK);
 		if (err == -EAGAIN) {
 			err = 0;
@@ -879,39 +1931,126 @@ static int xeth_mux_main(void *v)
 			continue;
 		}
 		xeth_mux_set_sb_connection(mux);
-		xeth_mux_reset_all_link_stats(mux);
-		xeth_mux_reset_all_port_ethtool_stats(mux);
 		err = xeth_mux_service_sb(mux, conn);
 		sock_release(conn);
 		xeth_mux_clear_sb_connection(mux);
-		xeth_mux_drop_all_port_carrier(mux);
+		xeth_mux_clear_sb_compact(mux);
+		xeth_mux_clear_sb_gen(mux);
+		xeth_mux_clear_sb_ifinfo_dirty(mux);
+		xeth_mux_clear_sb_fibinfo_dirty(mux);
+		xeth_mux_clear_sb_ifinfo_dump(mux);
+		xeth_mux_clear_sb_regen(mux);
+		xeth_mux_begin_carrier_grace(mux);
 	}
 	return xeth_mux_main_exit(mux, ln, err);
 }
 
+static int xeth_mux_poll(struct napi_struct *napi, int budget);
+
+static void xeth_mux_rx_ipi(void *info)
+{
+	struct xeth_mux_rx *rx = info;
+
+	atomic_set(&rx->csd_busy, 0);
+	napi_schedule(&rx->napi);
+}
+
+static int xeth_mux_init(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_mux_rx *rx;
+	int cpu, prio;
+
+	priv->sb.journal = vmalloc(xeth_mux_journal_sz);
+	if (!priv->sb.journal)
+		return -ENOMEM;
+	priv->rx = alloc_percpu(struct xeth_mux_rx);
+	if (!priv->rx) {
+		vfree(priv->sb.journal);
+		priv->sb.journal = NULL;
+		return -ENOMEM;
+	}
+	for_each_possible_cpu(cpu) {
+		rx = per_cpu_ptr(priv->rx, cpu);
+		rx->mux = mux;
+		for (prio = 0; prio <= XETH_VLAN_PRIO_MAX; prio++)
+			skb_queue_head_init(&rx->rxq[prio]);
+		rx->csd.func = xeth_mux_rx_ipi;
+		rx->csd.info = rx;
+		atomic_set(&rx->csd_busy, 0);
+		xeth_netif_napi_add(mux, &rx->napi, xeth_mux_poll);
+	}
+	return 0;
+}
+
+static void xeth_mux_purge_rxq(struct xeth_mux_priv *priv)
+{
+	struct xeth_mux_rx *rx;
+	struct sk_buff *skb;
+	int cpu, prio;
+
+	for_each_possible_cpu(cpu) {
+		rx = per_cpu_ptr(priv->rx, cpu);
+		for (prio = 0; prio <= XETH_VLAN_PRIO_MAX; prio++)
+			while ((skb = skb_dequeue(&rx->rxq[prio]))) {
+				dev_put(xeth_mux_rx_cb(skb)->nd);
+				kfree_skb(skb);
+			}
+	}
+}
+
 static void xeth_mux_uninit(struct net_device *mux)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	struct net_device *lower;
 	struct list_head *lowers;
-	int i;
+	bool csd_busy = false;
+	u8 *journal;
+	int i, ms;
 
 	if (xeth_mux_has_main_task(mux)) {
 		kthread_stop(priv->main);
 		priv->main = NULL;
 		while (xeth_mux_has_main_task(mux)) ;
 	}
+	xeth_mux_lock_sb(priv);
+	journal = priv->sb.journal;
+	priv->sb.journal = NULL;
+	xeth_mux_unlock_sb(priv);
+	vfree(journal);
 
 	netdev_for_each_lower_dev(mux, lower, lowers)
 		xeth_mux_del_lower(mux, lower);
-	for (i = 0; i < xeth_mux_link_hash_bkts; i++)
-		priv->link[i] = NULL;
+	xeth_mux_purge_rxq(priv);
+	del_timer_sync(&priv->tx_wake);
+	/* with the lowers gone nothing queues another IPI, so the one in
+	 * flight, if any, soon runs; if not, leak rather than free the rx
+	 * contexts beneath it
+	 */
+	for_each_possible_cpu(i) {
+		struct xeth_mux_rx *rx = per_cpu_ptr(priv->rx, i);
+
+		for (ms = 0; atomic_read(&rx->csd_busy); ms++) {
+			if (ms >= xeth_mux_csd_flush_ms) {
+				xeth_nd_err(mux, "cpu%d: rx IPI stuck", i);
+				csd_busy = true;
+				break;
+			}
+			msleep(1);
+		}
+		netif_napi_del(&rx->napi);
+	}
+	if (!csd_busy)
+		free_percpu(priv->rx);
+	priv->rx = NULL;
 }
 
 static int xeth_mux_open(struct net_device *mux)
 {
+	struct xeth_mux_priv *priv = netdev_priv(mux);
 	struct net_device *lower;
 	struct list_head *lowers;
+	int cpu;
 
 	netdev_for_each_lower_dev(mux, lower, lowers)
 		if (!(lower->flags & IFF_UP))
@@ -919,25 +2058,209 @@ static int xeth_mux_open(struct net_device *mux)
 
 	xeth_mux_check_lower_carrier(mux);
 
+	for_each_possible_cpu(cpu)
+		napi_enable(&per_cpu_ptr(priv->rx, cpu)->napi);
+	queue_delayed_work(system_long_wq, &priv->dom_work,
+			   xeth_mux_dom_period());
+	return 0;
+}
+
+static int xeth_mux_stop(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct net_device *lower;
+	struct list_head *lowers;
+	int cpu;
+
+	cancel_delayed_work_sync(&priv->dom_work);
+	if (netif_carrier_ok(mux))
+		netif_carrier_off(mux);
+	netdev_for_each_lower_dev(mux, lower, lowers)
+		dev_close(lower);
+	for_each_possible_cpu(cpu)
+		napi_disable(&per_cpu_ptr(priv->rx, cpu)->napi);
+	xeth_mux_purge_rxq(priv);
+	del_timer_sync(&priv->tx_wake);
+	priv->congested = 0;
+	xeth_mux_tx_wake(&priv->tx_wake);
 	return 0;
 }
 
-static int xeth_mux_stop(struct net_device *mux)
+static int xeth_mux_link_hash_vlan(struct sk_buff *skb)
+{
+	u16 tci;
+	return vlan_get_tag(skb, &tci) ? 0 : xeth_mux_link_hash_xid(tci);
+}
+
+static enum xeth_mux_ex xeth_mux_ex_tcp(struct sk_buff *skb, int off)
+{
+	struct tcphdr _th, *th;
+
+	th = skb_header_pointer(skb, off, sizeof(_th), &_th);
+	return th && (th->source == htons(179) || th->dest == htons(179)) ?
+		xeth_mux_ex_bgp : xeth_mux_ex_other;
+}
+
+static enum xeth_mux_ex xeth_mux_ex_udp(struct sk_buff *skb, int off)
+{
+	struct udphdr _uh, *uh;
+
+	uh = skb_header_pointer(skb, off, sizeof(_uh), &_uh);
+	if (!uh)
+		return xeth_mux_ex_other;
+	switch (ntohs(uh->dest)) {
+	case 3784:	/* BFD control */
+	case 3785:	/* BFD echo */
+	case 4784:	/* BFD multihop */
+		return xeth_mux_ex_ctl;
+	}
+	return xeth_mux_ex_other;
+}
+
+/* Classify by the protocol that follows the IP header at @off, if known. */
+static enum xeth_mux_ex xeth_mux_ex_l4(struct sk_buff *skb, u8 proto, int off)
+{
+	struct icmp6hdr _ic, *ic;
+
+	switch (proto) {
+	case IPPROTO_TCP:
+		return xeth_mux_ex_tcp(skb, off);
+	case IPPROTO_UDP:
+		return xeth_mux_ex_udp(skb, off);
+	case IPPROTO_IGMP:
+	case IPPROTO_PIM:
+	case 89:	/* OSPF */
+	case 112:	/* VRRP */
+		return xeth_mux_ex_ctl;
+	case IPPROTO_ICMPV6:
+		ic = skb_header_pointer(skb, off, sizeof(_ic), &_ic);
+		if (!ic)
+			break;
+		if (ic->icmp6_type >= NDISC_ROUTER_SOLICITATION &&
+		    ic->icmp6_type <= NDISC_REDIRECT)
+			return xeth_mux_ex_nd;
+		if (ic->icmp6_type == ICMPV6_MGM_QUERY ||
+		    ic->icmp6_type == ICMPV6_MGM_REPORT ||
+		    ic->icmp6_type == ICMPV6_MGM_REDUCTION ||
+		    ic->icmp6_type == ICMPV6_MLD2_REPORT)
+			return xeth_mux_ex_ctl;
+		break;
+	}
+	return xeth_mux_ex_other;
+}
+
+/* skb->data is at the inner tag or network header of the exception. Classify
+ * by protocol before TTL or hop limit expiry since single-hop eBGP, OSPF, PIM,
+ * and IGMP all send with a TTL of 1.
+ */
+static enum xeth_mux_ex xeth_mux_ex_of(struct sk_buff *skb)
+{
+	__be16 _proto, *proto = &skb->protocol;
+	struct ipv6hdr _ip6h, *ip6h;
+	struct iphdr _iph, *iph;
+	enum xeth_mux_ex ex;
+	int off = 0;
+
+	if (is_link_local_ether_addr(eth_hdr(skb)->h_dest))
+		return xeth_mux_ex_ctl;
+	if (eth_type_vlan(*proto)) {
+		proto = skb_header_pointer(skb, 2, sizeof(_proto), &_proto);
+		if (!proto)
+			return xeth_mux_ex_other;
+		off = VLAN_HLEN;
+	}
+	switch (*proto) {
+	case htons(ETH_P_SLOW):
+		return xeth_mux_ex_ctl;
+	case htons(ETH_P_ARP):
+		return xeth_mux_ex_arp;
+	case htons(ETH_P_IP):
+		iph = skb_header_pointer(skb, off, sizeof(_iph), &_iph);
+		if (!iph)
+			break;
+		ex = iph->frag_off & htons(IP_OFFSET) ? xeth_mux_ex_other :
+			xeth_mux_ex_l4(skb, iph->protocol,
+				       off + (iph->ihl * 4));
+		if (ex == xeth_mux_ex_other && iph->ttl <= 1)
+			ex = xeth_mux_ex_ttl;
+		return ex;
+	case htons(ETH_P_IPV6):
+		ip6h = skb_header_pointer(skb, off, sizeof(_ip6h), &_ip6h);
+		if (!ip6h)
+			break;
+		ex = xeth_mux_ex_l4(skb, ip6h->nexthdr,
+				    off + sizeof(*ip6h));
+		if (ex == xeth_mux_ex_other && ip6h->hop_limit <= 1)
+			ex = xeth_mux_ex_ttl;
+		return ex;
+	}
+	return xeth_mux_ex_other;
+}
+
+static bool xeth_mux_police(struct xeth_mux_policer *policer,
+			    unsigned int pps, unsigned int burst)
+{
+	u64 now, elapsed, credit, limit;
+	bool admit;
+
+	if (!pps)
+		return true;
+	limit = (u64)max(burst, 1U) * NSEC_PER_SEC;
+	spin_lock(&policer->lock);
+	now = ktime_get_ns();
+	elapsed = now - policer->stamp;
+	credit = elapsed >= div_u64(limit, pps) ?
+		limit : min(limit, policer->credit + (elapsed * pps));
+	admit = credit >= NSEC_PER_SEC;
+	if (admit)
+		credit -= NSEC_PER_SEC;
+	policer->credit = credit;
+	policer->stamp = now;
+	spin_unlock(&policer->lock);
+	return admit;
+}
+
+/* Report an admitted exception to its devlink trap from the mac header. */
+static void xeth_mux_report_ex(struct xeth_mux_priv *priv,
+			       struct sk_buff *skb, enum xeth_mux_ex ex)
+{
+#ifdef xeth_mux_devlink
+	struct devlink *devlink = READ_ONCE(priv->devlink);
+	void *trap_ctx = READ_ONCE(priv->ex_policers[ex].trap_ctx);
+	int mac_len;
+
+	if (!devlink || !trap_ctx)
+		return;
+	mac_len = skb->data - skb_mac_header(skb);
+	__skb_push(skb, mac_len);
+	devlink_trap_report(devlink, skb, trap_ctx, NULL, NULL);
+	__skb_pull(skb, mac_len);
+#endif
+}
+
+/* Police the exception by class and consume it if dropped. */
+static bool xeth_mux_admit_ex(struct net_device *mux, struct sk_buff *skb,
+			      enum xeth_mux_ex ex)
 {
-	struct net_device *lower;
-	struct list_head *lowers;
-
-	if (netif_carrier_ok(mux))
-		netif_carrier_off(mux);
-	netdev_for_each_lower_dev(mux, lower, lowers)
-		dev_close(lower);
-	return 0;
-}
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_mux_policer *policer = &priv->ex_policers[ex];
+	unsigned int pps, burst;
 
-static int xeth_mux_link_hash_vlan(struct sk_buff *skb)
-{
-	u16 tci;
-	return vlan_get_tag(skb, &tci) ? 0 : tci & 1;
+	if (READ_ONCE(policer->devlink)) {
+		pps = READ_ONCE(policer->pps);
+		burst = READ_ONCE(policer->burst);
+	} else {
+		pps = READ_ONCE(xeth_mux_ex_pps[ex]);
+		burst = READ_ONCE(xeth_mux_ex_burst);
+	}
+	if (xeth_mux_police(policer, pps, burst)) {
+		xeth_mux_report_ex(priv, skb, ex);
+		return true;
+	}
+	/* the dropped counters are in xeth_mux_ex order */
+	atomic64_inc(&priv->counters[xeth_mux_counter_ex_arp_dropped + ex]);
+	kfree_skb(skb);
+	return false;
 }
 
 static bool xeth_mux_was_vlan_exception(struct net_device *mux,
@@ -947,6 +2270,7 @@ static bool xeth_mux_was_vlan_exception(struct net_device *mux,
 	atomic64_t *counters = priv->counters;
 	struct vlan_ethhdr *veh = (struct vlan_ethhdr *)skb->data;
 	__be16 h_vlan_proto, h_vlan_encapsulated_proto;
+	enum xeth_mux_ex ex;
 	u16 tci;
 
 	if (!eth_type_vlan(veh->h_vlan_proto))
@@ -960,13 +2284,98 @@ static bool xeth_mux_was_vlan_exception(struct net_device *mux,
 	xeth_mux_add__ex_bytes(counters, skb->len);
 	eth_type_trans(skb, mux);
 	skb->vlan_proto = h_vlan_proto;
-	skb->vlan_tci = tci & ~VLAN_PRIO_MASK;
 	skb->protocol = h_vlan_encapsulated_proto;
 	skb_pull_inline(skb, VLAN_HLEN);
+	ex = xeth_mux_ex_of(skb);
+	if (!xeth_mux_admit_ex(mux, skb, ex))
+		return true;
+	skb->vlan_tci = (tci & ~VLAN_PRIO_MASK) |
+		((u16)xeth_mux_ex_prio[ex] << VLAN_PRIO_SHIFT);
 	xeth_mux_demux_vlan(mux, skb);
 	return true;
 }
 
+#ifdef xeth_mux_xdp
+/* set while the mux runs its program so an XDP_TX, or redirect, back
+ * through the mux is dropped rather than received again
+ */
+static DEFINE_PER_CPU(bool, xeth_mux_in_xdp);
+
+/* Run the generic XDP program with the bpf_net_context that a redirect
+ * needs; from the transmit path, there's none set by the caller.
+ */
+static u32 xeth_mux_run_xdp(struct bpf_prog *prog, struct sk_buff **pskb)
+{
+#ifdef xeth_bpf_net_ctx
+	struct bpf_net_context __bpf_net_ctx, *bpf_net_ctx;
+#endif
+	u32 act;
+
+	local_bh_disable();
+#ifdef xeth_bpf_net_ctx
+	bpf_net_ctx = bpf_net_ctx_set(&__bpf_net_ctx);
+#endif
+	__this_cpu_write(xeth_mux_in_xdp, true);
+	act = xeth_do_xdp_generic(prog, pskb);
+	__this_cpu_write(xeth_mux_in_xdp, false);
+#ifdef xeth_bpf_net_ctx
+	bpf_net_ctx_clear(bpf_net_ctx);
+#endif
+	local_bh_enable();
+	return act;
+}
+#endif /* xeth_mux_xdp */
+
+/* count a frame received through the mux by the result of its forward */
+static void xeth_mux_received(atomic64_t *ls, int err, unsigned int len)
+{
+	if (err == NET_RX_SUCCESS) {
+		xeth_inc_RX_PACKETS(ls);
+		xeth_add_RX_BYTES(ls, len);
+	} else {
+		xeth_inc_TX_ERRORS(ls);
+		xeth_inc_TX_ABORTED_ERRORS(ls);
+	}
+}
+
+/* Receive a switch-less or unlinked-switch proxy transmit frame through the
+ * mux for the daemon's raw socket or, with an attached program, through XDP
+ * that may redirect it to an AF_XDP socket. Each mux rx queue has the frames
+ * of every n'th port so the daemon may spread these over that many sockets.
+ * This consumes and counts the skb; do_xdp_generic() doesn't distinguish
+ * the program's drops from its redirects, so the mux counts both in
+ * xdp_consumed rather than as received.
+ */
+static void xeth_mux_receive(struct net_device *mux, struct sk_buff *skb)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	atomic64_t *ls = priv->link_stats;
+	unsigned int len = skb->len;
+#ifdef xeth_mux_xdp
+	struct bpf_prog *prog = rcu_dereference_bh(priv->xdp_prog);
+	u16 tci;
+
+	if (prog && this_cpu_read(xeth_mux_in_xdp)) {
+		xeth_inc_RX_DROPPED(ls);
+		kfree_skb(skb);
+		return;
+	}
+	if (prog) {
+		if (mux->real_num_rx_queues > 1 && !vlan_get_tag(skb, &tci))
+			skb_record_rx_queue(skb, (tci & VLAN_VID_MASK) %
+					    mux->real_num_rx_queues);
+		if (__dev_forward_skb(mux, skb))
+			xeth_mux_received(ls, NET_RX_DROP, len);
+		else if (xeth_mux_run_xdp(prog, &skb) == XDP_PASS)
+			xeth_mux_received(ls, netif_rx(skb), len);
+		else
+			xeth_mux_inc__xdp_consumed(priv->counters);
+		return;
+	}
+#endif
+	xeth_mux_received(ls, dev_forward_skb(mux, skb), len);
+}
+
 static netdev_tx_t xeth_mux_vlan_xmit(struct sk_buff *skb,
 				      struct net_device *mux)
 {
@@ -974,15 +2383,18 @@ static netdev_tx_t xeth_mux_vlan_xmit(struct sk_buff *skb,
 	atomic64_t *ls = priv->link_stats;
 	struct net_device *link;
 	unsigned int len = skb->len;
+	int bkt;
 
 	if (xeth_mux_was_vlan_exception(mux, skb))
 		return NETDEV_TX_OK;
-	link = priv->link[xeth_mux_link_hash_vlan(skb)];
+	bkt = xeth_mux_link_hash_vlan(skb);
+	link = xeth_mux_link(priv, bkt);
 	if (link) {
 		if (link->flags & IFF_UP) {
 			skb->dev = link;
 			no_xeth_debug_skb(skb);
 			if (dev_queue_xmit(skb)) {
+				xeth_mux_congest(priv, bkt);
 				xeth_inc_TX_DROPPED(ls);
 			} else {
 				xeth_inc_TX_PACKETS(ls);
@@ -995,14 +2407,7 @@ static netdev_tx_t xeth_mux_vlan_xmit(struct sk_buff *skb,
 		}
 	} else {
 		skb->dev = mux;
-		if (dev_forward_skb(mux, skb) == NET_RX_SUCCESS) {
-			xeth_inc_RX_PACKETS(ls);
-			xeth_add_RX_BYTES(ls, len);
-		} else {
-			xeth_inc_TX_ERRORS(ls);
-			xeth_inc_TX_ABORTED_ERRORS(ls);
-			kfree_skb(skb);
-		}
+		xeth_mux_receive(mux, skb);
 	}
 	return NETDEV_TX_OK;
 }
@@ -1011,6 +2416,17 @@ static netdev_tx_t xeth_mux_xmit(struct sk_buff *skb, struct net_device *mux)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	switch (priv->encap) {
+	case XETH_ENCAP_TRAP:
+		if (skb->len >= ETH_HLEN &&
+		    ((struct ethhdr *)skb->data)->h_proto ==
+		    htons(XETH_ETH_P_TRAP)) {
+			xeth_mux_inc__ex_frames(priv->counters);
+			xeth_mux_add__ex_bytes(priv->counters, skb->len);
+			eth_type_trans(skb, mux);
+			xeth_mux_demux_trap(mux, skb);
+			return NETDEV_TX_OK;
+		}
+		/* fall through */
 	case XETH_ENCAP_VLAN:
 		return xeth_mux_vlan_xmit(skb, mux);
 	case XETH_ENCAP_VPLS:
@@ -1022,12 +2438,51 @@ static netdev_tx_t xeth_mux_xmit(struct sk_buff *skb, struct net_device *mux)
 	return NETDEV_TX_OK;
 }
 
+/* Stop a proxy that has a qdisc while its link is congested so that its
+ * frames queue there rather than drop at the link; without one, the stopped
+ * noqueue proxy would instead drop every frame. The wake timer only visits
+ * the proxies listed here.
+ */
+static void xeth_mux_backpressure(struct xeth_mux_priv *priv,
+				  struct net_device *nd, int bkt)
+{
+	struct xeth_proxy *proxy = netdev_priv(nd);
+	struct netdev_queue *txq = netdev_get_tx_queue(nd, 0);
+
+	if (!test_bit(bkt, &priv->congested) ||
+	    !rcu_dereference_bh(txq->qdisc)->enqueue)
+		return;
+	netif_tx_stop_all_queues(nd);
+	xeth_mux_inc__proxy_tx_stopped(priv->counters);
+	spin_lock(&priv->tx_stopped_lock);
+	if (list_empty(&proxy->tx_stopped))
+		list_add_tail(&proxy->tx_stopped, &priv->tx_stopped);
+	spin_unlock(&priv->tx_stopped_lock);
+	/* recheck lest the wake timer cleared the bucket before the stop */
+	smp_mb();
+	if (!test_bit(bkt, &priv->congested))
+		netif_tx_wake_all_queues(nd);
+}
+
+/* PCP of the outer tag so that the switch may service host control traffic
+ * ahead of bulk; skb->priority remains for the lower link's own tc mapping.
+ */
+static u16 xeth_mux_egress_pcp(struct sk_buff *skb)
+{
+	u16 pcp = 0;
+
+	if (skb->priority <= TC_BITMASK)
+		pcp = READ_ONCE(xeth_mux_egress_qos_map[skb->priority]);
+	return min_t(u16, pcp, XETH_VLAN_PRIO_MAX - 1) << VLAN_PRIO_SHIFT;
+}
+
 static netdev_tx_t xeth_mux_vlan_encap_xmit(struct sk_buff *skb,
 					    struct net_device *nd)
 {
 	struct xeth_proxy *proxy = netdev_priv(nd);
 	struct xeth_mux_priv *priv = netdev_priv(proxy->mux);
 	u16 tpid = cpu_to_be16(ETH_P_8021Q);
+	u16 pcp = xeth_mux_egress_pcp(skb);
 
 	if (proxy->kind == XETH_DEV_KIND_VLAN) {
 		u16 vid = proxy->xid >> XETH_ENCAP_VLAN_VID_BIT;
@@ -1035,16 +2490,18 @@ static netdev_tx_t xeth_mux_vlan_encap_xmit(struct sk_buff *skb,
 		if (skb) {
 			tpid = cpu_to_be16(ETH_P_8021AD);
 			vid = proxy->xid & XETH_ENCAP_VLAN_VID_MASK;
-			skb = vlan_insert_tag_set_proto(skb, tpid, vid);
+			skb = vlan_insert_tag_set_proto(skb, tpid, pcp | vid);
 		}
 	} else {
 		u16 vid = proxy->xid & XETH_ENCAP_VLAN_VID_MASK;
-		skb = vlan_insert_tag_set_proto(skb, tpid, vid);
+		skb = vlan_insert_tag_set_proto(skb, tpid, pcp | vid);
 	}
 	if (skb) {
 		skb->dev = proxy->mux;
 		if (proxy->mux->flags & IFF_UP) {
 			dev_queue_xmit(skb);
+			xeth_mux_backpressure(priv, nd,
+					      xeth_mux_link_hash_xid(proxy->xid));
 		} else {
 			atomic64_t *ls = priv->link_stats;
 			xeth_inc_TX_ERRORS(ls);
@@ -1060,6 +2517,7 @@ netdev_tx_t xeth_mux_encap_xmit(struct sk_buff *skb, struct net_device *nd)
 	struct xeth_proxy *proxy = netdev_priv(nd);
 	switch (xeth_mux_encap(proxy->mux)) {
 	case XETH_ENCAP_VLAN:
+	case XETH_ENCAP_TRAP:
 		return xeth_mux_vlan_encap_xmit(skb, nd);
 	case XETH_ENCAP_VPLS:
 		/* FIXME vpls */
@@ -1077,28 +2535,122 @@ static void xeth_mux_get_stats64(struct net_device *mux,
 	xeth_link_stats(dst, priv->link_stats);
 }
 
-static void xeth_mux_demux_vlan(struct net_device *mux, struct sk_buff *skb)
+static void xeth_mux_forward_rx(struct net_device *mux, struct net_device *nd,
+				struct sk_buff *skb, bool napi)
 {
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	atomic64_t *ls = priv->link_stats;
-	struct xeth_proxy *proxy = NULL;
-	u32 xid;
+	unsigned int len = skb->len;
+	u32 mark = xeth_mux_rx_cb(skb)->mark;
+	int err;
 
-	skb->priority =
-		(typeof(skb->priority))(skb->vlan_tci >> VLAN_PRIO_SHIFT);
-	xid = skb->vlan_tci & VLAN_VID_MASK;
-	if (eth_type_vlan(skb->protocol)) {
-		__be16 tci = *(__be16*)(skb->data);
-		__be16 proto = *(__be16*)(skb->data+2);
-		xid |= (u32)(be16_to_cpu(tci) & VLAN_VID_MASK) <<
-			XETH_ENCAP_VLAN_VID_BIT;
-		skb->protocol = proto;
-		skb_pull_inline(skb, VLAN_HLEN);
+	err = __dev_forward_skb(nd, skb);
+	if (!err) {
+		if (mark)
+			skb->mark = mark;
+		err = napi ? netif_receive_skb(skb) : netif_rx(skb);
+	}
+	if (err == NET_RX_SUCCESS) {
+		xeth_inc_RX_PACKETS(ls);
+		xeth_add_RX_BYTES(ls, len);
+	} else
+		xeth_inc_RX_DROPPED(ls);
+}
+
+/* Without a steering table, the demuxing cpu also receives the frame; this
+ * concentrates all proxy traffic on the few cpus that service the lower
+ * links, so the table spreads it by xid instead. The mux's own entry for
+ * the xid, shared by its VLANs, precedes the module's modulus table.
+ */
+static int xeth_mux_steer_cpu(struct xeth_mux_priv *priv, u32 xid)
+{
+	unsigned int cpu = READ_ONCE(priv->steer[xid & VLAN_VID_MASK]);
+	int n;
+
+	if (cpu)
+		cpu--;
+	else {
+		n = READ_ONCE(xeth_mux_n_steer);
+		if (n <= 0)
+			return smp_processor_id();
+		cpu = READ_ONCE(xeth_mux_steer[xid % n]);
+	}
+	return cpu < nr_cpu_ids && cpu_online(cpu) ? cpu : smp_processor_id();
+}
+
+/* Queue the demuxed frame by priority so that the mux NAPI context receives
+ * control and exception frames ahead of bulk data; otherwise, a burst of
+ * the latter would delay the former behind it in the shared cpu backlog.
+ */
+static void xeth_mux_queue_rx(struct net_device *mux, struct net_device *nd,
+			      struct sk_buff *skb, u32 xid)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	atomic64_t *ls = priv->link_stats;
+	struct sk_buff_head *rxq;
+	struct xeth_mux_rx *rx;
+	int cpu;
+
+	if (!netif_running(mux)) {
+		xeth_mux_forward_rx(mux, nd, skb, false);
+		return;
+	}
+	cpu = xeth_mux_steer_cpu(priv, xid);
+	rx = per_cpu_ptr(priv->rx, cpu);
+	rxq = &rx->rxq[skb->priority & XETH_VLAN_PRIO_MAX];
+	if (skb_queue_len(rxq) >= READ_ONCE(xeth_mux_rxq_len)) {
+		xeth_inc_RX_DROPPED(ls);
+		xeth_inc_RX_FIFO_ERRORS(ls);
+		dev_kfree_skb_any(skb);
+		return;
+	}
+	dev_hold(nd);
+	xeth_mux_rx_cb(skb)->nd = nd;
+	skb_queue_tail(rxq, skb);
+	if (cpu == smp_processor_id())
+		napi_schedule(&rx->napi);
+	else if (!atomic_xchg(&rx->csd_busy, 1) &&
+		 smp_call_function_single_async(cpu, &rx->csd)) {
+		/* the cpu went offline so receive its queue here */
+		atomic_set(&rx->csd_busy, 0);
+		napi_schedule(&rx->napi);
+	}
+}
+
+static int xeth_mux_poll(struct napi_struct *napi, int budget)
+{
+	struct xeth_mux_rx *rx = container_of(napi, struct xeth_mux_rx, napi);
+	struct net_device *nd;
+	struct sk_buff *skb;
+	int prio, done = 0;
+
+	while (done < budget) {
+		skb = NULL;
+		for (prio = XETH_VLAN_PRIO_MAX; !skb && prio >= 0; prio--)
+			skb = skb_dequeue(&rx->rxq[prio]);
+		if (!skb)
+			break;
+		nd = xeth_mux_rx_cb(skb)->nd;
+		xeth_mux_forward_rx(rx->mux, nd, skb, true);
+		dev_put(nd);
+		done++;
 	}
+	if (done < budget)
+		napi_complete_done(napi, done);
+	return done;
+}
+
+/* skb->data is at the payload and skb->protocol its ethertype */
+static void xeth_mux_demux_xid(struct net_device *mux, struct sk_buff *skb,
+			       u32 xid)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	atomic64_t *ls = priv->link_stats;
+	struct xeth_proxy *proxy;
+
 	proxy = xeth_mux_proxy_of_xid(mux, xid);
 	if (!proxy) {
-		no_xeth_debug("no proxy for xid %d; tci 0x%x",
-			xid, skb->vlan_tci);
+		no_xeth_debug("no proxy for xid %d", xid);
 		xeth_inc_RX_ERRORS(ls);
 		xeth_inc_RX_NOHANDLER(ls);
 		dev_kfree_skb(skb);
@@ -1111,17 +2663,85 @@ static void xeth_mux_demux_vlan(struct net_device *mux, struct sk_buff *skb)
 		eth->h_proto = skb->protocol;
 		skb->vlan_proto = 0;
 		skb->vlan_tci = 0;
-		if (dev_forward_skb(proxy->nd, skb) == NET_RX_SUCCESS) {
-			xeth_inc_RX_PACKETS(ls);
-			xeth_add_RX_BYTES(ls, skb->len);
-		} else
-			xeth_inc_RX_DROPPED(ls);
+		xeth_mux_queue_rx(mux, proxy->nd, skb, xid);
 	} else {
 		xeth_inc_RX_DROPPED(ls);
 		dev_kfree_skb(skb);
 	}
 }
 
+static void xeth_mux_demux_vlan(struct net_device *mux, struct sk_buff *skb)
+{
+	u32 xid;
+
+	skb->priority =
+		(typeof(skb->priority))(skb->vlan_tci >> VLAN_PRIO_SHIFT);
+	xeth_mux_rx_cb(skb)->mark = 0;
+	xid = skb->vlan_tci & VLAN_VID_MASK;
+	if (eth_type_vlan(skb->protocol)) {
+		__be16 tci = *(__be16*)(skb->data);
+		__be16 proto = *(__be16*)(skb->data+2);
+		xid |= (u32)(be16_to_cpu(tci) & VLAN_VID_MASK) <<
+			XETH_ENCAP_VLAN_VID_BIT;
+		skb->protocol = proto;
+		skb_pull_inline(skb, VLAN_HLEN);
+	}
+	xeth_mux_demux_xid(mux, skb, xid);
+}
+
+static enum xeth_mux_ex xeth_mux_ex_of_trap(struct sk_buff *skb, u16 reason)
+{
+	switch (reason) {
+	case XETH_TRAP_REASON_L2_CONTROL:
+	case XETH_TRAP_REASON_BFD:
+		return xeth_mux_ex_ctl;
+	case XETH_TRAP_REASON_ARP:
+		return xeth_mux_ex_arp;
+	case XETH_TRAP_REASON_ND:
+		return xeth_mux_ex_nd;
+	case XETH_TRAP_REASON_TTL:
+		return xeth_mux_ex_ttl;
+	case XETH_TRAP_REASON_BGP:
+		return xeth_mux_ex_bgp;
+	case XETH_TRAP_REASON_UNSPEC:
+		return xeth_mux_ex_of(skb);
+	}
+	return xeth_mux_ex_other;
+}
+
+/* Demux a trapped frame by the xid of its xeth_trap_hdr, which also has its
+ * priority and reason, so there's no parse of the frame itself unless the
+ * reason is unspecified. The reason is the receive mark of the frame and
+ * the switch ingress time, if any, its hardware timestamp.
+ *
+ * skb->data is at the trap header that follows the source address.
+ */
+static void xeth_mux_demux_trap(struct net_device *mux, struct sk_buff *skb)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	atomic64_t *ls = priv->link_stats;
+	struct xeth_trap_hdr th;
+	u16 reason;
+
+	if (!pskb_may_pull(skb, sizeof(th))) {
+		xeth_inc_RX_ERRORS(ls);
+		xeth_inc_RX_LENGTH_ERRORS(ls);
+		kfree_skb(skb);
+		return;
+	}
+	th = *(struct xeth_trap_hdr *)skb->data;
+	skb_pull_inline(skb, sizeof(th));
+	skb->protocol = th.proto;
+	reason = ntohs(th.reason);
+	if (!xeth_mux_admit_ex(mux, skb, xeth_mux_ex_of_trap(skb, reason)))
+		return;
+	skb->priority = th.prio & XETH_VLAN_PRIO_MAX;
+	xeth_mux_rx_cb(skb)->mark = reason;
+	if (th.flags & (1 << XETH_TRAP_FLAG_TSTAMP_BIT))
+		skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(be64_to_cpu(th.tstamp));
+	xeth_mux_demux_xid(mux, skb, ntohl(th.xid));
+}
+
 static rx_handler_result_t xeth_mux_demux(struct sk_buff **pskb)
 {
 	struct sk_buff *skb = *pskb;
@@ -1129,7 +2749,12 @@ static rx_handler_result_t xeth_mux_demux(struct sk_buff **pskb)
 	struct xeth_mux_priv *priv = netdev_priv(mux);
 	atomic64_t *ls = priv->link_stats;
 
-	if (eth_type_vlan(skb->vlan_proto)) {
+	if (priv->encap == XETH_ENCAP_TRAP &&
+	    skb->protocol == htons(XETH_ETH_P_TRAP)) {
+		xeth_mux_inc__ex_frames(priv->counters);
+		xeth_mux_add__ex_bytes(priv->counters, skb->len);
+		xeth_mux_demux_trap(mux, skb);
+	} else if (eth_type_vlan(skb->vlan_proto)) {
 		xeth_mux_demux_vlan(mux, skb);
 	} else {
 		/* FIXME vpls */
@@ -1141,12 +2766,62 @@ static rx_handler_result_t xeth_mux_demux(struct sk_buff **pskb)
 	return RX_HANDLER_CONSUMED;
 }
 
+#ifdef xeth_mux_xdp
+static int xeth_mux_bpf(struct net_device *mux, struct netdev_bpf *xdp)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct bpf_prog *old;
+
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		old = rtnl_dereference(priv->xdp_prog);
+		rcu_assign_pointer(priv->xdp_prog, xdp->prog);
+		if (old)
+			bpf_prog_put(old);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* XDP_REDIRECT of another device's frames to the mux transmits them like
+ * those sent through the daemon's raw socket. Copy-mode AF_XDP transmit
+ * doesn't come here; __dev_direct_xmit() sends those through
+ * ndo_start_xmit.
+ */
+static int xeth_mux_xdp_xmit(struct net_device *mux, int n,
+			     struct xdp_frame **frames, u32 flags)
+{
+	struct sk_buff *skb;
+	int i;
+
+	if (flags & ~XDP_XMIT_FLAGS_MASK)
+		return -EINVAL;
+	if (!netif_running(mux))
+		return -ENETDOWN;
+	for (i = 0; i < n; i++) {
+		skb = xdp_build_skb_from_frame(frames[i], mux);
+		if (!skb)
+			break;
+		/* the build pulled the ethernet header that xmit expects */
+		skb_push(skb, ETH_HLEN);
+		xeth_mux_xmit(skb, mux);
+	}
+	return i;
+}
+#endif /* xeth_mux_xdp */
+
 const struct net_device_ops xeth_mux_ndo = {
+	.ndo_init	= xeth_mux_init,
 	.ndo_uninit	= xeth_mux_uninit,
 	.ndo_open	= xeth_mux_open,
 	.ndo_stop	= xeth_mux_stop,
 	.ndo_start_xmit	= xeth_mux_xmit,
 	.ndo_get_stats64= xeth_mux_get_stats64,
+#ifdef xeth_mux_xdp
+	.ndo_bpf	= xeth_mux_bpf,
+	.ndo_xdp_xmit	= xeth_mux_xdp_xmit,
+#endif
 };
 
 static void xeth_mux_eto_get_drvinfo(struct net_device *nd,
@@ -1240,7 +2915,7 @@ static int xeth_mux_newlink(struct net *src_net, struct net_device *mux,
 					nla_get_u32(tb[IFLA_LINK]));
 		if (IS_ERR_OR_NULL(link)) {
 			NL_SET_ERR_MSG(ack, "unkown link");
-			return PTR_ERR(priv->link);
+			return link ? PTR_ERR(link) : -ENODEV;
 		}
 		eth_hw_addr_inherit(mux, link);
 		mux->addr_assign_type = NET_ADDR_STOLEN;
@@ -1353,6 +3028,8 @@ void xeth_mux_ifname(struct device *dev, char ifname[])
 
 static enum xeth_encap xeth_mux_encap_prop(struct device *dev)
 {
+	if (device_property_present(dev, "encap-trap"))
+		return XETH_ENCAP_TRAP;
 	return device_property_present(dev, "encap-vpls") ?
 		XETH_ENCAP_VPLS : XETH_ENCAP_VLAN;
 }
@@ -1504,6 +3181,34 @@ static size_t xeth_mux_stats_prop(struct device *dev,
 	return n;
 }
 
+/* "xid-reserved" is a list of first, last pairs of xids that aren't
+ * available to proxies created by the mux or netlink.
+ */
+static void xeth_mux_reserved_xids_prop(struct device *dev,
+					unsigned long *free_xids)
+{
+	static const char label[] = "xid-reserved";
+	u32 *ranges;
+	int i, n;
+
+	if (!device_property_present(dev, label))
+		return;
+
+	n = device_property_read_u32_array(dev, label, NULL, 0);
+	if (n <= 0 || n & 1)
+		return;
+	ranges = kcalloc(n, sizeof(*ranges), GFP_KERNEL);
+	if (!ranges)
+		return;
+	if (!device_property_read_u32_array(dev, label, ranges, n))
+		for (i = 0; i < n; i += 2)
+			if (ranges[i] <= ranges[i+1] &&
+			    ranges[i+1] < XETH_VLAN_N_VID)
+				bitmap_clear(free_xids, ranges[i],
+					     ranges[i+1] - ranges[i] + 1);
+	kfree(ranges);
+}
+
 static void xeth_mux_qsfp_i2c_addrs_prop(struct device *dev, u16 *addrs)
 {
 	static const char label[] = "qsfp-i2c-addrs";
@@ -1820,6 +3525,263 @@ static void xeth_mux_platina_mk1_ppds(struct net_device *mux)
 	}
 }
 
+#ifdef xeth_mux_devlink
+
+/* Each exception class has a driver trap of its own group and policer so
+ * that devlink shows and sets the class's rate, burst, and drops. The
+ * policer id of each class is one past its xeth_mux_ex.
+ */
+enum {
+	xeth_mux_devlink_trap_id = DEVLINK_TRAP_GENERIC_ID_MAX + 1,
+	xeth_mux_devlink_group_id = DEVLINK_TRAP_GROUP_GENERIC_ID_MAX + 1,
+	xeth_mux_devlink_max_rate = 1000000,
+	xeth_mux_devlink_max_burst = 65536,
+};
+
+struct xeth_mux_devlink {
+	struct net_device *mux;
+	struct devlink_trap_policer policers[xeth_mux_n_ex];
+};
+
+#define xeth_mux_devlink_group(ex)					\
+	{								\
+		.name = "xeth_" #ex,					\
+		.id = xeth_mux_devlink_group_id + xeth_mux_ex_##ex,	\
+		.generic = false,					\
+		.init_policer_id = 1 + xeth_mux_ex_##ex,		\
+	}
+
+#define xeth_mux_devlink_trap(type, ex)					\
+	DEVLINK_TRAP_DRIVER(type, TRAP,					\
+			    xeth_mux_devlink_trap_id + xeth_mux_ex_##ex,\
+			    "xeth_" #ex,				\
+			    xeth_mux_devlink_group_id + xeth_mux_ex_##ex,\
+			    0)
+
+static const struct devlink_trap_group xeth_mux_devlink_groups[] = {
+	xeth_mux_devlink_group(arp),
+	xeth_mux_devlink_group(nd),
+	xeth_mux_devlink_group(ttl),
+	xeth_mux_devlink_group(bgp),
+	xeth_mux_devlink_group(ctl),
+	xeth_mux_devlink_group(other),
+};
+
+static const struct devlink_trap xeth_mux_devlink_traps[] = {
+	xeth_mux_devlink_trap(CONTROL, arp),
+	xeth_mux_devlink_trap(CONTROL, nd),
+	xeth_mux_devlink_trap(EXCEPTION, ttl),
+	xeth_mux_devlink_trap(CONTROL, bgp),
+	xeth_mux_devlink_trap(CONTROL, ctl),
+	xeth_mux_devlink_trap(EXCEPTION, other),
+};
+
+static struct xeth_mux_priv *xeth_mux_devlink_priv(struct devlink *devlink)
+{
+	struct xeth_mux_devlink *xdl = devlink_priv(devlink);
+
+	return netdev_priv(xdl->mux);
+}
+
+static int xeth_mux_devlink_trap_init(struct devlink *devlink,
+				      const struct devlink_trap *trap,
+				      void *trap_ctx)
+{
+	struct xeth_mux_priv *priv = xeth_mux_devlink_priv(devlink);
+	u16 ex = trap->id - xeth_mux_devlink_trap_id;
+
+	if (ex >= xeth_mux_n_ex)
+		return -EINVAL;
+	WRITE_ONCE(priv->ex_policers[ex].trap_ctx, trap_ctx);
+	return 0;
+}
+
+static void xeth_mux_devlink_trap_fini(struct devlink *devlink,
+				       const struct devlink_trap *trap,
+				       void *trap_ctx)
+{
+	struct xeth_mux_priv *priv = xeth_mux_devlink_priv(devlink);
+	u16 ex = trap->id - xeth_mux_devlink_trap_id;
+
+	if (ex < xeth_mux_n_ex)
+		WRITE_ONCE(priv->ex_policers[ex].trap_ctx, NULL);
+}
+
+/* exceptions are always trapped to the cpu */
+static int
+xeth_mux_devlink_trap_action_set(struct devlink *devlink,
+				 const struct devlink_trap *trap,
+				 enum devlink_trap_action action,
+				 struct netlink_ext_ack *extack)
+{
+	NL_SET_ERR_MSG_MOD(extack, "exception traps have a fixed action");
+	return -EOPNOTSUPP;
+}
+
+static int
+xeth_mux_devlink_trap_policer_set(struct devlink *devlink,
+				  const struct devlink_trap_policer *policer,
+				  u64 rate, u64 burst,
+				  struct netlink_ext_ack *extack)
+{
+	struct xeth_mux_priv *priv = xeth_mux_devlink_priv(devlink);
+	struct xeth_mux_policer *xp;
+
+	if (policer->id < 1 || policer->id > xeth_mux_n_ex)
+		return -EINVAL;
+	xp = &priv->ex_policers[policer->id - 1];
+	WRITE_ONCE(xp->pps, rate);
+	WRITE_ONCE(xp->burst, burst);
+	WRITE_ONCE(xp->devlink, true);
+	return 0;
+}
+
+static int
+xeth_mux_devlink_trap_policer_init(struct devlink *devlink,
+				   const struct devlink_trap_policer *policer)
+{
+	return xeth_mux_devlink_trap_policer_set(devlink, policer,
+						 policer->init_rate,
+						 policer->init_burst, NULL);
+}
+
+static int
+xeth_mux_devlink_trap_policer_counter_get(struct devlink *devlink,
+					  const struct devlink_trap_policer
+					  *policer,
+					  u64 *p_drops)
+{
+	struct xeth_mux_priv *priv = xeth_mux_devlink_priv(devlink);
+	atomic64_t *dropped = &priv->counters[xeth_mux_counter_ex_arp_dropped];
+
+	if (policer->id < 1 || policer->id > xeth_mux_n_ex)
+		return -EINVAL;
+	/* the dropped counters are in xeth_mux_ex order */
+	*p_drops = atomic64_read(&dropped[policer->id - 1]);
+	return 0;
+}
+
+static const struct devlink_ops xeth_mux_devlink_ops = {
+	.trap_init = xeth_mux_devlink_trap_init,
+	.trap_fini = xeth_mux_devlink_trap_fini,
+	.trap_action_set = xeth_mux_devlink_trap_action_set,
+	.trap_policer_init = xeth_mux_devlink_trap_policer_init,
+	.trap_policer_set = xeth_mux_devlink_trap_policer_set,
+	.trap_policer_counter_get = xeth_mux_devlink_trap_policer_counter_get,
+};
+
+static int xeth_mux_devlink_traps_register(struct devlink *devlink)
+{
+	struct xeth_mux_devlink *xdl = devlink_priv(devlink);
+	int err;
+
+	err = devl_trap_policers_register(devlink, xdl->policers,
+					  xeth_mux_n_ex);
+	if (err)
+		return err;
+	err = devl_trap_groups_register(devlink, xeth_mux_devlink_groups,
+					ARRAY_SIZE(xeth_mux_devlink_groups));
+	if (err)
+		goto groups_err;
+	err = devl_traps_register(devlink, xeth_mux_devlink_traps,
+				  ARRAY_SIZE(xeth_mux_devlink_traps), NULL);
+	if (err)
+		goto traps_err;
+	return 0;
+traps_err:
+	devl_trap_groups_unregister(devlink, xeth_mux_devlink_groups,
+				    ARRAY_SIZE(xeth_mux_devlink_groups));
+groups_err:
+	devl_trap_policers_unregister(devlink, xdl->policers, xeth_mux_n_ex);
+	return err;
+}
+
+/* Register a devlink instance of the mux's platform device with a policer
+ * initially of the ex_pps and ex_burst module parameters for each class.
+ * This must be outside of the rtnl, which nests within the devlink lock.
+ */
+static void xeth_mux_devlink_register(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct xeth_mux_devlink *xdl;
+	struct devlink *devlink;
+	int i, err;
+
+	devlink = devlink_alloc(&xeth_mux_devlink_ops, sizeof(*xdl),
+				&priv->pd->dev);
+	if (!devlink) {
+		xeth_nd_err(mux, "devlink_alloc: %d", -ENOMEM);
+		return;
+	}
+	xdl = devlink_priv(devlink);
+	xdl->mux = mux;
+	for (i = 0; i < xeth_mux_n_ex; i++) {
+		struct devlink_trap_policer *policer = &xdl->policers[i];
+
+		policer->id = i + 1;
+		policer->init_rate = min_t(u64, READ_ONCE(xeth_mux_ex_pps[i]),
+					   xeth_mux_devlink_max_rate);
+		policer->init_burst =
+			clamp_t(u64, READ_ONCE(xeth_mux_ex_burst), 1,
+				xeth_mux_devlink_max_burst);
+		policer->max_rate = xeth_mux_devlink_max_rate;
+		policer->min_rate = 0;
+		policer->max_burst = xeth_mux_devlink_max_burst;
+		policer->min_burst = 1;
+	}
+
+	devl_lock(devlink);
+	err = xeth_mux_devlink_traps_register(devlink);
+	devl_unlock(devlink);
+	if (err) {
+		xeth_nd_err(mux, "devlink traps: %d", err);
+		for (i = 0; i < xeth_mux_n_ex; i++)
+			WRITE_ONCE(priv->ex_policers[i].devlink, false);
+		devlink_free(devlink);
+		return;
+	}
+	devlink_register(devlink);
+	WRITE_ONCE(priv->devlink, devlink);
+}
+
+static void xeth_mux_devlink_unregister(struct net_device *mux)
+{
+	struct xeth_mux_priv *priv = netdev_priv(mux);
+	struct devlink *devlink = priv->devlink;
+	struct xeth_mux_devlink *xdl;
+	int i;
+
+	if (!devlink)
+		return;
+	xdl = devlink_priv(devlink);
+	/* wait for reports in progress before the traps are gone */
+	WRITE_ONCE(priv->devlink, NULL);
+	synchronize_net();
+	devlink_unregister(devlink);
+	devl_lock(devlink);
+	devl_traps_unregister(devlink, xeth_mux_devlink_traps,
+			      ARRAY_SIZE(xeth_mux_devlink_traps));
+	devl_trap_groups_unregister(devlink, xeth_mux_devlink_groups,
+				    ARRAY_SIZE(xeth_mux_devlink_groups));
+	devl_trap_policers_unregister(devlink, xdl->policers, xeth_mux_n_ex);
+	devl_unlock(devlink);
+	for (i = 0; i < xeth_mux_n_ex; i++)
+		WRITE_ONCE(priv->ex_policers[i].devlink, false);
+	devlink_free(devlink);
+}
+
+#else /* !xeth_mux_devlink */
+
+static void xeth_mux_devlink_register(struct net_device *mux)
+{
+}
+
+static void xeth_mux_devlink_unregister(struct net_device *mux)
+{
+}
+
+#endif /* xeth_mux_devlink */
+
 static int xeth_mux_probe(struct platform_device *pd)
 {
 	struct device *dev = &pd->dev;
@@ -1873,6 +3835,7 @@ static int xeth_mux_probe(struct platform_device *pd)
 	priv->stat_name.named =
 		xeth_mux_stats_prop(dev, priv->stat_name.names);
 	xeth_mux_qsfp_i2c_addrs_prop(dev, priv->qsfp_i2c_addrs);
+	xeth_mux_reserved_xids_prop(dev, priv->proxy.free_xids);
 
 	if (n_links > 0)
 		eth_hw_addr_inherit(mux, links[0]);
@@ -1911,12 +3874,17 @@ static int xeth_mux_probe(struct platform_device *pd)
 	priv->reset_gpios =
 		gpiod_get_array_optional(dev, "reset", GPIOD_OUT_LOW);
 
-	if (n_ppds) {
+	rtnl_unlock();
+
+	xeth_mux_devlink_register(mux);
+
+	/* port devices probe asynchronously and take the rtnl themselves */
+	if (n_ppds && mk_ppds) {
 		priv->n_ppds = n_ppds;
 		mk_ppds(mux);
 	}
 
-	return xeth_rtnl_unlock(0);
+	return 0;
 }
 
 static int xeth_mux_remove(struct platform_device *pd)
@@ -1936,6 +3904,8 @@ static int xeth_mux_remove(struct platform_device *pd)
 		if (priv->ppds[i])
 			platform_device_unregister(priv->ppds[i]);
 
+	xeth_mux_devlink_unregister(mux);
+
 	rtnl_lock();
 	xeth_mux_lnko.dellink(mux, &q);
 	unregister_netdevice_many(&q);
@@ -11,8 +11,6 @@
 
 #include <net/ip_fib.h>
 
-static void xeth_nb_stop_net_fib(struct net_device *mux, struct net *net);
-
 static int xeth_nb_fib(struct notifier_block *fib, unsigned long event,
 		       void *ptr)
 {
@@ -44,6 +42,9 @@ static int xeth_nb_fib(struct notifier_block *fib, unsigned long event,
 	case FIB_EVENT_RULE_DEL:
 	case FIB_EVENT_NH_ADD:
 	case FIB_EVENT_NH_DEL:
+		/* these NH events are of legacy fib_nh liveness; nexthop
+		 * objects are relayed by xeth_nb_nexthop()
+		 */
 	case FIB_EVENT_VIF_ADD:
 	case FIB_EVENT_VIF_DEL:
 		break;
@@ -53,6 +54,29 @@ static int xeth_nb_fib(struct notifier_block *fib, unsigned long event,
 	return NOTIFY_DONE;
 }
 
+#if defined(nexthop_notifier_info_type)
+static int xeth_nb_nexthop(struct notifier_block *nh, unsigned long event,
+			   void *ptr)
+{
+	struct xeth_fibmuxnet *fmn = container_of(nh, typeof(*fmn), nh);
+	struct nh_notifier_info *info = ptr;
+
+	if (nh->notifier_call != xeth_nb_nexthop || READ_ONCE(fmn->stopped))
+		return NOTIFY_DONE;
+	switch (event) {
+	case NEXTHOP_EVENT_REPLACE:
+		xeth_sbtx_nexthop(fmn->mux, fmn->net, info,
+				  XETH_NEXTHOP_EVENT_REPLACE);
+		break;
+	case NEXTHOP_EVENT_DEL:
+		xeth_sbtx_nexthop(fmn->mux, fmn->net, info,
+				  XETH_NEXTHOP_EVENT_DEL);
+		break;
+	}
+	return NOTIFY_DONE;
+}
+#endif
+
 int xeth_nb_inetaddr(struct notifier_block *inetaddr, unsigned long event,
 		     void *ptr)
 {
@@ -139,15 +163,34 @@ int xeth_nb_netdevice(struct notifier_block *netdevice, unsigned long event,
 	proxy = xeth_mux_proxy_of_nd(mux, nd);
 	switch (event) {
 	case NETDEV_CHANGE:
+	case NETDEV_UP:
 		xeth_mux_check_lower_carrier(mux);
 		break;
+	case NETDEV_DOWN:
+		xeth_mux_check_lower_carrier(mux);
+		/* the kernel has already deleted the routes through this
+		 * proxy; sbtx suppressed those w/o other next hops so
+		 * summarize their withdrawal
+		 */
+		if (proxy && proxy->xid && proxy->mux == mux &&
+		    xeth_nb_has_net_fib(mux, dev_net(nd)))
+			xeth_sbtx_fib_flush_dev(proxy);
+		break;
 	case NETDEV_REGISTER:
-		/* also notifies dev_change_net_namespace */
+		/* also notifies dev_change_net_namespace; the sbtx service
+		 * starts the netns fib notifier after sending this REG
+		 */
 		if (proxy && proxy->xid && proxy->mux)
 			xeth_sbtx_ifinfo(proxy, 0, XETH_IFINFO_REASON_REG);
 		break;
 	case NETDEV_UNREGISTER:
-		/* lgnored here, handled by @xeth_UPPER_dellink() */
+		/* otherwise handled by @xeth_UPPER_dellink(); here, stop the
+		 * netns fib notifier when its last proxy leaves
+		 */
+		if (proxy && proxy->mux == mux &&
+		    !net_eq(dev_net(nd), &init_net) &&
+		    !xeth_mux_has_proxy_in_net(mux, dev_net(nd), nd))
+			xeth_nb_stop_net_fib(mux, dev_net(nd));
 		break;
 	case NETDEV_CHANGEMTU:
 		if (dev_get_iflink(nd) == nd->ifindex) {
@@ -194,66 +237,261 @@ static int xeth_nb_start_fib(struct net_device *mux, struct net *net)
 	struct xeth_nb *nb = xeth_mux_nb(mux);
 	struct xeth_fibmuxnet *fmn;
 
+	mutex_lock(&nb->fibs_mutex);
 	list_for_each_entry(fmn, &nb->fibs, list)
-		if (fmn->net == net)
+		if (fmn->net == net) {
+			mutex_unlock(&nb->fibs_mutex);
 			return -EBUSY;
-	fmn = devm_kzalloc(&mux->dev, sizeof(*fmn), GFP_KERNEL);
+		}
+	mutex_unlock(&nb->fibs_mutex);
+	fmn = kzalloc(sizeof(*fmn), GFP_KERNEL);
 	if (!fmn)
 		return -ENOMEM;
 	fmn->fib.notifier_call = xeth_nb_fib;
+#if defined(nexthop_notifier_info_type)
+	fmn->nh.notifier_call = xeth_nb_nexthop;
+#endif
 	fmn->mux = mux;
 	fmn->net = net;
+	/* register w/o the mutex since the fib dump takes rtnl */
 	err = xeth_fibmuxnet_register(fmn);
-	if (!err)
-		list_add_tail(&fmn->list, &nb->fibs);
-	return err;
+	if (err) {
+		kfree(fmn);
+		return err;
+	}
+	mutex_lock(&nb->fibs_mutex);
+	list_add_tail(&fmn->list, &nb->fibs);
+	mutex_unlock(&nb->fibs_mutex);
+	return 0;
 }
 
-int xeth_nb_start_new_fib(struct net_device *mux, struct net *net)
+bool xeth_nb_has_net_fib(struct net_device *mux, struct net *net)
 {
-#if defined(fib_notifier_info_without_net)
 	struct xeth_nb *nb = xeth_mux_nb(mux);
+	struct xeth_fibmuxnet *fmn;
+	bool has = false;
 
-	/* don't start fib notifications on new nets until DUMP_FIBINFO */
-	if (!list_empty(&nb->fibs))
-		return xeth_nd_prif_err(mux, xeth_nb_start_fib(mux, net));
-#endif
+	mutex_lock(&nb->fibs_mutex);
+	list_for_each_entry(fmn, &nb->fibs, list)
+		if (fmn->net == net) {
+			has = true;
+			break;
+		}
+	mutex_unlock(&nb->fibs_mutex);
+	return has;
+}
+
+static bool xeth_nb_has_fibs(struct net_device *mux)
+{
+	struct xeth_nb *nb = xeth_mux_nb(mux);
+	bool has;
+
+	mutex_lock(&nb->fibs_mutex);
+	has = !list_empty(&nb->fibs);
+	mutex_unlock(&nb->fibs_mutex);
+	return has;
+}
+
+/**
+ * xeth_nb_start_net_fib() - lazy start of a netns fib notifier
+ *
+ * This is deferred to the sbtx service after a proxy registers in @net since
+ * the fib notifier registration dump can't run with the netdevice notifier's
+ * rtnl held.
+ */
+int xeth_nb_start_net_fib(struct net_device *mux, struct net *net)
+{
+#if defined(fib_notifier_info_without_net)
+	int err;
+
+	/* don't start fib notifications on other nets until DUMP_FIBINFO */
+	if (net_eq(net, &init_net) || !xeth_nb_has_fibs(mux))
+		return 0;
+	if (!xeth_mux_has_proxy_in_net(mux, net, NULL))
+		return 0;
+	err = xeth_nb_start_fib(mux, net);
+	return err == -EBUSY ? 0 : err;
+#else
 	return 0;
+#endif
 }
 
+struct xeth_nb_netref {
+	struct list_head list;
+	struct net *net;
+};
+
+/**
+ * xeth_nb_start_all_fib() - start fib notifiers on DUMP_FIBINFO
+ *
+ * Beyond the default, this only starts notifiers in the netns with proxies;
+ * other netns are started as proxies move there.
+ *
+ * Since it yields between netns, this walks a referenced snapshot of the
+ * netns list rather than hold net_rwsem.
+ */
 int xeth_nb_start_all_fib(struct net_device *mux)
 {
+	struct xeth_nb_netref *ref, *tmp;
 	struct net *net;
-	int err;
+	LIST_HEAD(refs);
+	int err = 0;
 
 	xeth_nd_prif_err(mux, xeth_nb_start_fib(mux, &init_net));
-	list_for_each_entry(net, &net_namespace_list, list)
-		if (net != &init_net)
-			if (err = xeth_nb_start_new_fib(mux, net), err)
-				return err;
+	down_read(&net_rwsem);
+	for_each_net(net) {
+		if (net == &init_net)
+			continue;
+		ref = kmalloc(sizeof(*ref), GFP_KERNEL);
+		if (!ref) {
+			err = -ENOMEM;
+			break;
+		}
+		ref->net = maybe_get_net(net);
+		if (ref->net)
+			list_add_tail(&ref->list, &refs);
+		else
+			kfree(ref);
+	}
+	up_read(&net_rwsem);
+	list_for_each_entry_safe(ref, tmp, &refs, list) {
+		if (!err) {
+			/* send the previous netns dump before the next */
+			xeth_mux_yield_sbtx(mux);
+			err = xeth_nb_start_net_fib(mux, ref->net);
+		}
+		put_net(ref->net);
+		list_del(&ref->list);
+		kfree(ref);
+	}
+	return err;
+}
+
+#if defined(nexthop_notifier_info_type)
+/* stopped fib mux nets pending unregister_nexthop_notifier(), which takes
+ * the rtnl that the netdevice notifier and mux uninit already hold; these
+ * may outlive their mux so the list is module wide
+ */
+static LIST_HEAD(xeth_nb_nh_stale);
+static DEFINE_MUTEX(xeth_nb_nh_stale_mutex);
+
+/* a dying netns is left to xeth_nb_net_exit() */
+static void xeth_nb_reap_nh(struct work_struct *work)
+{
+	struct xeth_fibmuxnet *fmn, *tmp;
+	LIST_HEAD(reap);
+
+	mutex_lock(&xeth_nb_nh_stale_mutex);
+	list_for_each_entry_safe(fmn, tmp, &xeth_nb_nh_stale, list)
+		if (maybe_get_net(fmn->net))
+			list_move_tail(&fmn->list, &reap);
+	mutex_unlock(&xeth_nb_nh_stale_mutex);
+	list_for_each_entry_safe(fmn, tmp, &reap, list) {
+		struct net *net = fmn->net;
+
+		unregister_nexthop_notifier(net, &fmn->nh);
+		list_del(&fmn->list);
+		kfree(fmn);
+		put_net(net);
+	}
+}
+
+static DECLARE_WORK(xeth_nb_reap_nh_work, xeth_nb_reap_nh);
+
+/* this pernet exit precedes that of nexthop */
+static void xeth_nb_net_exit(struct net *net)
+{
+	struct xeth_fibmuxnet *fmn, *tmp;
+	LIST_HEAD(reap);
+
+	mutex_lock(&xeth_nb_nh_stale_mutex);
+	list_for_each_entry_safe(fmn, tmp, &xeth_nb_nh_stale, list)
+		if (fmn->net == net)
+			list_move_tail(&fmn->list, &reap);
+	mutex_unlock(&xeth_nb_nh_stale_mutex);
+	list_for_each_entry_safe(fmn, tmp, &reap, list) {
+		unregister_nexthop_notifier(net, &fmn->nh);
+		list_del(&fmn->list);
+		kfree(fmn);
+	}
+}
+
+static struct pernet_operations xeth_nb_net_ops = {
+	.exit = xeth_nb_net_exit,
+};
+#endif /* nexthop_notifier_info_type */
+
+int xeth_nb_init(void)
+{
+#if defined(nexthop_notifier_info_type)
+	return register_pernet_subsys(&xeth_nb_net_ops);
+#else
 	return 0;
+#endif
+}
+
+/* after the muxes, this unregister reaps the stale of every remaining netns */
+void xeth_nb_exit(void)
+{
+#if defined(nexthop_notifier_info_type)
+	flush_work(&xeth_nb_reap_nh_work);
+	unregister_pernet_subsys(&xeth_nb_net_ops);
+#endif
 }
 
-static void xeth_nb_stop_net_fib(struct net_device *mux, struct net *net)
+/* the caller has removed fmn from its mux list */
+static void xeth_nb_stop_fmn(struct xeth_fibmuxnet *fmn)
+{
+	xeth_fibmuxnet_unregister_fib(fmn);
+#if defined(nexthop_notifier_info_type)
+	WRITE_ONCE(fmn->stopped, true);
+	mutex_lock(&xeth_nb_nh_stale_mutex);
+	list_add_tail(&fmn->list, &xeth_nb_nh_stale);
+	mutex_unlock(&xeth_nb_nh_stale_mutex);
+	schedule_work(&xeth_nb_reap_nh_work);
+#else
+	kfree(fmn);
+#endif
+}
+
+/**
+ * xeth_nb_stop_net_fib() - stop and flush a netns fib
+ *
+ * Rather than the kernel deleting each route of a dying netns, this sends a
+ * single FIB_FLUSH of all its tables.
+ */
+void xeth_nb_stop_net_fib(struct net_device *mux, struct net *net)
 {
 	struct xeth_nb *nb = xeth_mux_nb(mux);
 	struct xeth_fibmuxnet *fmn, *tmp;
+	LIST_HEAD(stop);
 
+	mutex_lock(&nb->fibs_mutex);
 	list_for_each_entry_safe(fmn, tmp, &nb->fibs, list)
-		if (fmn->net == net) {
-			xeth_fibmuxnet_unregister(fmn);
-			list_del(&fmn->list);
-		}
+		if (fmn->net == net)
+			list_move_tail(&fmn->list, &stop);
+	mutex_unlock(&nb->fibs_mutex);
+	if (list_empty(&stop))
+		return;
+	list_for_each_entry_safe(fmn, tmp, &stop, list) {
+		list_del(&fmn->list);
+		xeth_nb_stop_fmn(fmn);
+	}
+	xeth_sbtx_fib_flush(mux, net, RT_TABLE_UNSPEC);
 }
 
 void xeth_nb_stop_all_fib(struct net_device *mux)
 {
 	struct xeth_nb *nb = xeth_mux_nb(mux);
 	struct xeth_fibmuxnet *fmn, *tmp;
+	LIST_HEAD(stop);
 
-	list_for_each_entry_safe(fmn, tmp, &nb->fibs, list) {
-		xeth_fibmuxnet_unregister(fmn);
+	mutex_lock(&nb->fibs_mutex);
+	list_splice_init(&nb->fibs, &stop);
+	mutex_unlock(&nb->fibs_mutex);
+	list_for_each_entry_safe(fmn, tmp, &stop, list) {
 		list_del(&fmn->list);
+		xeth_nb_stop_fmn(fmn);
 	}
 }
 
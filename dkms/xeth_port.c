@@ -9,21 +9,57 @@
 
 enum {
 	xeth_port_top_vid = 3999,
+	/* wait for a changed module to settle before reconciling its client */
+	xeth_port_qsfp_settle_ms = 2000,
+	xeth_port_mc_to_mk = 273150,
 };
 
 static const char xeth_port_drvname[] = "xeth-port";
 static ssize_t xeth_port_subports(size_t port);
+/* serializes the re-provision of ports through sysfs */
+static DEFINE_MUTEX(xeth_port_provision_mutex);
 
 struct xeth_port_ext {
+	/* @qsfp_mutex: orders attach and detach of @qsfp with its readers */
+	struct mutex qsfp_mutex;
 	struct i2c_client *qsfp;
+	/* @qsfp_work: attaches or detaches @qsfp on @qsfp_bus per absent */
+	struct delayed_work qsfp_work;
+	/* @absent_irq, @intr_irq: zero if the line can't interrupt */
+	int absent_irq, intr_irq;
+	u8 qsfp_bus;
+	/* @dom: last sample by the mux, zero w/o module */
+	spinlock_t dom_lock;
+	struct xeth_qsfp_dom dom;
 	u32 priv_flags;
 	atomic64_t stats[xeth_mux_max_stats];
 };
 
+static const char * const xeth_port_dom_stat_names[] = {
+	"qsfp_temp_mK",
+	"qsfp_vcc_uV",
+	"qsfp_rx1_power_nW",
+	"qsfp_rx2_power_nW",
+	"qsfp_rx3_power_nW",
+	"qsfp_rx4_power_nW",
+	"qsfp_tx1_bias_uA",
+	"qsfp_tx2_bias_uA",
+	"qsfp_tx3_bias_uA",
+	"qsfp_tx4_bias_uA",
+	"qsfp_tx1_power_nW",
+	"qsfp_tx2_power_nW",
+	"qsfp_tx3_power_nW",
+	"qsfp_tx4_power_nW",
+};
+
 struct xeth_port_priv {
 	struct xeth_proxy proxy;
 	int port, subport;
 	struct ethtool_link_ksettings ksettings;
+	/* @carrier_stale: kept through a sideband disconnect but not yet
+	 * refreshed by the reconnected switch daemon
+	 */
+	bool carrier_stale;
 	/* @ext: only included w/ subport[0] */
 	struct xeth_port_ext ext[];
 };
@@ -43,9 +79,19 @@ int xeth_port_subport(struct net_device *nd)
 static void xeth_port_uninit(struct net_device *nd)
 {
 	struct xeth_port_priv *priv = netdev_priv(nd);
-	if (priv->subport <= 0 && priv->ext[0].qsfp) {
-		i2c_unregister_device(priv->ext[0].qsfp);
-		priv->ext[0].qsfp = NULL;
+	if (priv->subport <= 0) {
+		if (priv->ext[0].absent_irq)
+			free_irq(priv->ext[0].absent_irq, priv);
+		if (priv->ext[0].intr_irq)
+			free_irq(priv->ext[0].intr_irq, priv);
+		cancel_delayed_work_sync(&priv->ext[0].qsfp_work);
+		/* the mux sampler may still hold this port */
+		mutex_lock(&priv->ext[0].qsfp_mutex);
+		if (priv->ext[0].qsfp) {
+			xeth_qsfp_unregister(priv->ext[0].qsfp);
+			WRITE_ONCE(priv->ext[0].qsfp, NULL);
+		}
+		mutex_unlock(&priv->ext[0].qsfp_mutex);
 	}
 	xeth_proxy_uninit(nd);
 }
@@ -87,6 +133,78 @@ xeth_port_ethtool_ksettings(struct net_device *nd)
 	return &priv->ksettings;
 }
 
+bool xeth_port_carrier_stale(struct net_device *nd)
+{
+	struct xeth_port_priv *priv = netdev_priv(nd);
+	return priv->carrier_stale;
+}
+
+void xeth_port_set_carrier_stale(struct net_device *nd, bool stale)
+{
+	struct xeth_port_priv *priv = netdev_priv(nd);
+	priv->carrier_stale = stale;
+}
+
+void xeth_port_dump_qsfp(struct net_device *nd)
+{
+	struct xeth_port_priv *priv = netdev_priv(nd);
+
+	if (priv->subport <= 0 && priv->ext[0].qsfp_bus)
+		xeth_sbtx_qsfp(priv->proxy.mux, priv->proxy.xid,
+			       READ_ONCE(priv->ext[0].qsfp) ?
+			       XETH_QSFP_EVENT_INSERTED :
+			       XETH_QSFP_EVENT_REMOVED);
+}
+
+bool xeth_port_has_qsfp(struct net_device *nd)
+{
+	struct xeth_port_priv *priv = netdev_priv(nd);
+	return priv->subport <= 0 && READ_ONCE(priv->ext[0].qsfp);
+}
+
+/* Called by the mux sampler, this sleeps for the i2c read but the cached
+ * result is copied to the ethtool stats under a spinlock.
+ */
+void xeth_port_sample_dom(struct net_device *nd)
+{
+	struct xeth_port_priv *priv = netdev_priv(nd);
+	struct xeth_port_ext *ext = &priv->ext[0];
+	struct xeth_qsfp_dom dom;
+	int err = -ENXIO;
+
+	if (priv->subport > 0)
+		return;
+	mutex_lock(&ext->qsfp_mutex);
+	if (ext->qsfp)
+		err = xeth_qsfp_read_dom(ext->qsfp, &dom);
+	mutex_unlock(&ext->qsfp_mutex);
+	if (err)
+		memset(&dom, 0, sizeof(dom));
+	spin_lock(&ext->dom_lock);
+	ext->dom = dom;
+	spin_unlock(&ext->dom_lock);
+}
+
+static void xeth_port_get_dom_stats(struct xeth_port_priv *priv, u64 *data)
+{
+	struct xeth_port_ext *ext = &priv->ext[0];
+	struct xeth_qsfp_dom dom;
+	int i;
+
+	spin_lock(&ext->dom_lock);
+	dom = ext->dom;
+	spin_unlock(&ext->dom_lock);
+	/* kelvin keeps the u64 stat unsigned; zero w/o module as the rest */
+	*data++ = dom.vcc_uv ? dom.temp_mc + xeth_port_mc_to_mk : 0;
+	*data++ = dom.vcc_uv;
+	for (i = 0; i < ARRAY_SIZE(dom.rx_power_nw); i++)
+		*data++ = dom.rx_power_nw[i];
+	for (i = 0; i < ARRAY_SIZE(dom.tx_bias_ua); i++)
+		*data++ = dom.tx_bias_ua[i];
+	for (i = 0; i < ARRAY_SIZE(dom.tx_power_nw); i++)
+		*data++ = dom.tx_power_nw[i];
+}
+
 void xeth_port_reset_ethtool_stats(struct net_device *nd)
 {
 	struct xeth_port_priv *priv = netdev_priv(nd);
@@ -136,7 +254,8 @@ static void xeth_port_get_drvinfo(struct net_device *nd,
 	strlcpy(drvinfo->fw_version, "n/a", ETHTOOL_FWVERS_LEN);
 	strlcpy(drvinfo->erom_version, "n/a", ETHTOOL_EROMVERS_LEN);
 	drvinfo->n_priv_flags = xeth_mux_n_priv_flags(priv->proxy.mux);
-	drvinfo->n_stats = xeth_mux_n_stats(priv->proxy.mux);
+	drvinfo->n_stats = xeth_mux_n_stats(priv->proxy.mux) +
+		ARRAY_SIZE(xeth_port_dom_stat_names);
 	scnprintf(drvinfo->bus_info, ETHTOOL_BUSINFO_LEN, "%u:%u",
 		  priv->port, priv->proxy.xid);
 }
@@ -166,7 +285,8 @@ static int xeth_port_get_sset_count(struct net_device *nd, int sset)
 		n = 0;
 		break;
 	case ETH_SS_STATS:
-		n = xeth_mux_n_stats(priv->proxy.mux);
+		n = xeth_mux_n_stats(priv->proxy.mux) +
+			ARRAY_SIZE(xeth_port_dom_stat_names);
 		break;
 	case ETH_SS_PRIV_FLAGS:
 		n = xeth_mux_n_priv_flags(priv->proxy.mux);
@@ -181,12 +301,19 @@ static int xeth_port_get_sset_count(struct net_device *nd, int sset)
 static void xeth_port_get_strings(struct net_device *nd, u32 sset, u8 *data)
 {
 	struct xeth_port_priv *priv = netdev_priv(nd);
+	int i;
 
 	switch (sset) {
 	case ETH_SS_TEST:
 		break;
 	case ETH_SS_STATS:
 		xeth_mux_stat_names(priv->proxy.mux, data);
+		data += xeth_mux_n_stats(priv->proxy.mux) * ETH_GSTRING_LEN;
+		for (i = 0; i < ARRAY_SIZE(xeth_port_dom_stat_names); i++) {
+			strlcpy(data, xeth_port_dom_stat_names[i],
+				ETH_GSTRING_LEN);
+			data += ETH_GSTRING_LEN;
+		}
 		break;
 	case ETH_SS_PRIV_FLAGS:
 		xeth_mux_priv_flag_names(priv->proxy.mux, data);
@@ -204,6 +331,7 @@ static void xeth_port_get_stats(struct net_device *nd,
 
 	for (i = 0; i < n; i++)
 		data[i] = atomic64_read(&priv->ext[0].stats[i]);
+	xeth_port_get_dom_stats(priv, data + n);
 }
 
 static u32 xeth_port_get_priv_flags(struct net_device *nd)
@@ -505,17 +633,27 @@ int xeth_port_get_module_info(struct net_device *nd,
 			      struct ethtool_modinfo *emi)
 {
 	struct xeth_port_priv *priv = netdev_priv(nd);
-	return priv->ext[0].qsfp ?
+	int err;
+
+	mutex_lock(&priv->ext[0].qsfp_mutex);
+	err = priv->ext[0].qsfp ?
 		xeth_qsfp_get_module_info(priv->ext[0].qsfp, emi) : -ENXIO;
+	mutex_unlock(&priv->ext[0].qsfp_mutex);
+	return err;
 }
 
 int xeth_port_get_module_eeprom(struct net_device *nd,
 				struct ethtool_eeprom *ee, u8 *data)
 {
 	struct xeth_port_priv *priv = netdev_priv(nd);
-	return priv->ext[0].qsfp ?
+	int err;
+
+	mutex_lock(&priv->ext[0].qsfp_mutex);
+	err = priv->ext[0].qsfp ?
 		xeth_qsfp_get_module_eeprom(priv->ext[0].qsfp, ee, data) :
 		-ENXIO;
+	mutex_unlock(&priv->ext[0].qsfp_mutex);
+	return err;
 }
 
 static const struct ethtool_ops xeth_port_eto = {
@@ -559,22 +697,121 @@ static void xeth_port_setup(struct net_device *nd)
 	nd->priv_flags |= IFF_DONT_BRIDGE;
 }
 
-static void xeth_port_qsfp(struct xeth_port_priv *priv, u8 bus)
+/* Runs from system_long_wq after the port is registered, so that the i2c
+ * peeks of each module don't serialize the probe of every port, then after
+ * each change of the absent line.
+ */
+static void xeth_port_qsfp(struct work_struct *work)
 {
+	struct xeth_port_ext *ext =
+		container_of(work, struct xeth_port_ext, qsfp_work.work);
+	struct xeth_port_priv *priv =
+		container_of(ext, struct xeth_port_priv, ext[0]);
 	struct gpio_desc *absent_gpio =
 		xeth_mux_qsfp_absent_gpio(priv->proxy.mux, priv->port);
 	struct gpio_desc *reset_gpio =
 		xeth_mux_qsfp_reset_gpio(priv->proxy.mux, priv->port);
 	const unsigned short * const addrs =
 		xeth_mux_qsfp_i2c_addrs(priv->proxy.mux);
+	struct i2c_client *qsfp;
+	int event = -1;
+
 	if (!absent_gpio || !reset_gpio)
 		return;
-	if (gpiod_get_value_cansleep(absent_gpio))
-		return;
-	gpiod_set_value_cansleep(reset_gpio, 0);
-	priv->ext[0].qsfp = xeth_qsfp_client(bus, addrs);
-	if (!priv->ext[0].qsfp)
-		xeth_debug("qsfp[%d] not found @%d", priv->port, bus);
+	mutex_lock(&ext->qsfp_mutex);
+	if (gpiod_get_value_cansleep(absent_gpio)) {
+		qsfp = ext->qsfp;
+		if (qsfp) {
+			WRITE_ONCE(ext->qsfp, NULL);
+			xeth_qsfp_unregister(qsfp);
+			spin_lock(&ext->dom_lock);
+			memset(&ext->dom, 0, sizeof(ext->dom));
+			spin_unlock(&ext->dom_lock);
+			event = XETH_QSFP_EVENT_REMOVED;
+		}
+	} else if (!ext->qsfp) {
+		gpiod_set_value_cansleep(reset_gpio, 0);
+		WRITE_ONCE(ext->qsfp, xeth_qsfp_client(ext->qsfp_bus, addrs));
+		if (ext->qsfp)
+			event = XETH_QSFP_EVENT_INSERTED;
+		else
+			xeth_debug("qsfp[%d] not found @%d",
+				   priv->port, ext->qsfp_bus);
+	}
+	mutex_unlock(&ext->qsfp_mutex);
+	if (event >= 0)
+		xeth_sbtx_qsfp(priv->proxy.mux, priv->proxy.xid, event);
+}
+
+static irqreturn_t xeth_port_qsfp_absent_irq(int irq, void *data)
+{
+	struct xeth_port_priv *priv = data;
+	struct xeth_port_ext *ext = &priv->ext[0];
+
+	mutex_lock(&ext->qsfp_mutex);
+	if (ext->qsfp)
+		xeth_qsfp_invalidate(ext->qsfp);
+	mutex_unlock(&ext->qsfp_mutex);
+	mod_delayed_work(system_long_wq, &ext->qsfp_work,
+			 msecs_to_jiffies(xeth_port_qsfp_settle_ms));
+	return IRQ_HANDLED;
+}
+
+static irqreturn_t xeth_port_qsfp_intr_irq(int irq, void *data)
+{
+	struct xeth_port_priv *priv = data;
+
+	xeth_sbtx_qsfp(priv->proxy.mux, priv->proxy.xid,
+		       XETH_QSFP_EVENT_INTERRUPT);
+	return IRQ_HANDLED;
+}
+
+static int xeth_port_qsfp_irq(struct xeth_port_priv *priv,
+			      struct gpio_desc *gpio, irq_handler_t handler,
+			      unsigned long flags)
+{
+	int irq, err;
+
+	if (!gpio)
+		return 0;
+	irq = gpiod_to_irq(gpio);
+	if (irq <= 0)
+		return 0;
+	err = request_threaded_irq(irq, NULL, handler, flags | IRQF_ONESHOT,
+				   netdev_name(priv->proxy.nd), priv);
+	if (err) {
+		xeth_nd_err(priv->proxy.nd, "irq %d: %d", irq, err);
+		return 0;
+	}
+	return irq;
+}
+
+/* Without an absent interrupt, the module is only discovered at probe. */
+static void xeth_port_qsfp_irqs(struct xeth_port_priv *priv)
+{
+	struct net_device *mux = priv->proxy.mux;
+	struct xeth_port_ext *ext = &priv->ext[0];
+
+	ext->absent_irq = xeth_port_qsfp_irq(priv,
+		xeth_mux_qsfp_absent_gpio(mux, priv->port),
+		xeth_port_qsfp_absent_irq,
+		IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING);
+	ext->intr_irq = xeth_port_qsfp_irq(priv,
+		xeth_mux_qsfp_intr_gpio(mux, priv->port),
+		xeth_port_qsfp_intr_irq,
+		IRQF_TRIGGER_FALLING);
+}
+
+static void xeth_port_init_ext(struct xeth_port_priv *priv)
+{
+	struct xeth_port_ext *ext = &priv->ext[0];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ext->stats); i++)
+		atomic64_set(&ext->stats[i], 0LL);
+	mutex_init(&ext->qsfp_mutex);
+	INIT_DELAYED_WORK(&ext->qsfp_work, xeth_port_qsfp);
+	spin_lock_init(&ext->dom_lock);
 }
 
 static int xeth_port_validate(struct nlattr *tb[], struct nlattr *data[],
@@ -610,13 +847,23 @@ static int xeth_port_newlink(struct net *src_net, struct net_device *nd,
 	nd->max_mtu = priv->proxy.mux->max_mtu;
 	priv->port = -1;
 	priv->subport = -1;
+	xeth_port_init_ext(priv);
 
-	if (data && data[XETH_PORT_IFLA_XID])
+	if (data && data[XETH_PORT_IFLA_XID]) {
 		priv->proxy.xid = nla_get_u16(data[XETH_PORT_IFLA_XID]);
-	else
-		for (priv->proxy.xid = xeth_port_top_vid;
-		     xeth_mux_proxy_of_xid(priv->proxy.mux, priv->proxy.xid);
-		     priv->proxy.xid--);
+		err = xeth_mux_reserve_xid(priv->proxy.mux, priv->proxy.xid);
+		if (err) {
+			NL_SET_ERR_MSG(extack, "unavailable XID");
+			return err;
+		}
+	} else {
+		err = xeth_mux_alloc_xid(priv->proxy.mux, XETH_DEV_KIND_PORT);
+		if (err < 0) {
+			NL_SET_ERR_MSG(extack, "failed xid alloc");
+			return err;
+		}
+		priv->proxy.xid = err;
+	}
 
 	if (!tb || !tb[IFLA_IFNAME])
 		scnprintf(nd->name, IFNAMSIZ, "%s%u",
@@ -653,7 +900,9 @@ static const struct nla_policy xeth_port_nla_policy[] = {
 
 struct rtnl_link_ops xeth_port_lnko = {
 	.kind		= xeth_port_drvname,
-	.priv_size	= sizeof(struct xeth_port_priv),
+	/* rtnl made ports aren't subports so always have the extension */
+	.priv_size	= sizeof(struct xeth_port_priv) +
+			  sizeof(struct xeth_port_ext),
 	.setup		= xeth_port_setup,
 	.validate	= xeth_port_validate,
 	.newlink	= xeth_port_newlink,
@@ -696,7 +945,7 @@ static int xeth_port(struct platform_device *pd, struct net_device *mux,
 	struct net_device *nd;
 	struct xeth_port_priv *priv;
 	size_t sz;
-	int i, err;
+	int err;
 
 	sz = sizeof(*priv);
 	if (subport <= 0)
@@ -727,13 +976,17 @@ static int xeth_port(struct platform_device *pd, struct net_device *mux,
 	priv->port = port;
 	priv->subport = subport;
 
+	err = xeth_mux_reserve_xid(mux, priv->proxy.xid);
+	if (err) {
+		xeth_nd_err(nd, "xid %u unavailable", priv->proxy.xid);
+		free_netdev(nd);
+		return err;
+	}
+
 	if (subport <= 0) {
-		u8 bus = xeth_port_qsfp_bus_prop(pd);
 		nd->ethtool_ops = &xeth_port_eto;
-		for (i = 0; i < ARRAY_SIZE(priv->ext[0].stats); i++)
-			atomic64_set(&priv->ext[0].stats[i], 0LL);
-		if (bus)
-			xeth_port_qsfp(priv, bus);
+		xeth_port_init_ext(priv);
+		priv->ext[0].qsfp_bus = xeth_port_qsfp_bus_prop(pd);
 	} else
 		nd->ethtool_ops = &xeth_subport_eto;
 
@@ -746,6 +999,14 @@ static int xeth_port(struct platform_device *pd, struct net_device *mux,
 
 	rtnl_lock();
 	err = xeth_nd_prif_err(nd, register_netdevice(nd));
+	if (!err) {
+		if (subport <= 0 && priv->ext[0].qsfp_bus) {
+			xeth_port_qsfp_irqs(priv);
+			queue_delayed_work(system_long_wq,
+					   &priv->ext[0].qsfp_work, 0);
+		}
+		xeth_sbtx_ifinfo(&priv->proxy, 0, XETH_IFINFO_REASON_NEW);
+	}
 	rtnl_unlock();
 
 	if (err) {
@@ -755,22 +1016,36 @@ static int xeth_port(struct platform_device *pd, struct net_device *mux,
 	return err;
 }
 
-static int xeth_port_probe(struct platform_device *pd)
+/* Unregister the netdevs that xeth_port_make() provisioned for @port, each
+ * sending its own IFINFO DEL; those of other ports are left alone.
+ */
+static void xeth_port_unmake(struct net_device *mux, int port, int subports)
 {
-	struct net_device *mux;
-	char name[IFNAMSIZ], addr[ETH_ALEN];
-	int port, subports, err;
-	u8 base_port;
+	u16 ports = xeth_mux_ports(mux);
+	struct xeth_proxy *proxy;
+	int sp;
+	LIST_HEAD(q);
 
-	xeth_mux_ifname(pd->dev.parent, name);
-	mux = dev_get_by_name(&init_net, name);
-	if (!mux)
-		return -EPROBE_DEFER;
+	rtnl_lock();
+	for (sp = 0; sp < subports; sp++) {
+		u32 xid = xeth_port_top_vid - port - (sp * ports);
+		proxy = xeth_mux_proxy_of_xid(mux, xid);
+		if (proxy && proxy->kind == XETH_DEV_KIND_PORT &&
+		    xeth_port_of(proxy->nd) == port)
+			xeth_port_dellink(proxy->nd, &q);
+	}
+	unregister_netdevice_many(&q);
+	rtnl_unlock();
+}
+
+static int xeth_port_make(struct platform_device *pd, struct net_device *mux,
+			  int port, int subports)
+{
+	char name[IFNAMSIZ], addr[ETH_ALEN];
+	u8 base_port = xeth_mux_base_port(mux);
+	int err;
 
-	port = xeth_port_index_prop(pd);
 	xeth_port_addr_prop(pd, addr);
-	subports = xeth_port_subports(port);
-	base_port = xeth_mux_base_port(mux);
 
 	if (subports > 1) {
 		u16 ports = xeth_mux_ports(mux);
@@ -791,9 +1066,29 @@ static int xeth_port_probe(struct platform_device *pd)
 		err = xeth_port(pd, mux, name, port, -1, addr);
 	}
 
-	dev_put(mux);
-	if (err)
+	if (err) {
 		xeth_nd_err(mux, "can't make %s: %d\n", name, err);
+		/* rather than leave the port partially provisioned */
+		xeth_port_unmake(mux, port, subports > 1 ? subports : 1);
+	}
+	return err;
+}
+
+static int xeth_port_probe(struct platform_device *pd)
+{
+	struct net_device *mux;
+	char name[IFNAMSIZ];
+	int port, err;
+
+	xeth_mux_ifname(pd->dev.parent, name);
+	mux = dev_get_by_name(&init_net, name);
+	if (!mux)
+		return -EPROBE_DEFER;
+
+	/* unlocked, since the provision attribute follows probe */
+	port = xeth_port_index_prop(pd);
+	err = xeth_port_make(pd, mux, port, xeth_port_subports(port));
+	dev_put(mux);
 	return err;
 }
 
@@ -835,6 +1130,74 @@ static struct attribute *xeth_port_attrs[] = {
 
 ATTRIBUTE_GROUPS(xeth_port);
 
+static ssize_t provision_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	ssize_t subports =
+		xeth_port_subports(xeth_port_index_prop(to_platform_device(dev)));
+	if (subports < 0)
+		return subports;
+	return scnprintf(buf, PAGE_SIZE, "%zd\n", subports > 1 ? subports : 1);
+}
+
+/* Re-provision one port live: unregister its current netdevs then make the
+ * new set of 1, 2, or 4 subports without disturbing any other proxy. If the
+ * new set fails, the port reverts to its previous provision.
+ */
+static ssize_t provision_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t n)
+{
+	struct platform_device *pd = to_platform_device(dev);
+	struct net_device *mux;
+	char name[IFNAMSIZ];
+	ssize_t subports;
+	int port, err;
+	u8 val;
+
+	if (kstrtou8(buf, 0, &val))
+		return -EINVAL;
+	if (val != 1 && val != 2 && val != 4)
+		return -EINVAL;
+	port = xeth_port_index_prop(pd);
+	if (port < 0 || port >= ARRAY_SIZE(xeth_port_provision))
+		return -EINVAL;
+
+	xeth_mux_ifname(pd->dev.parent, name);
+	mux = dev_get_by_name(&init_net, name);
+	if (!mux)
+		return -ENODEV;
+
+	mutex_lock(&xeth_port_provision_mutex);
+	subports = xeth_port_subports(port);
+	if (subports < 1)
+		subports = 1;
+	if (subports != val) {
+		xeth_port_unmake(mux, port, subports);
+		err = xeth_port_make(pd, mux, port, val);
+		if (!err)
+			xeth_port_provision[port] = val;
+		else
+			xeth_nd_prif_err(mux,
+					 xeth_port_make(pd, mux, port,
+							subports));
+	} else
+		err = 0;
+	mutex_unlock(&xeth_port_provision_mutex);
+
+	dev_put(mux);
+	return err ? err : n;
+}
+
+static DEVICE_ATTR_RW(provision);
+
+static struct attribute *xeth_port_dev_attrs[] = {
+	&dev_attr_provision.attr,
+	NULL,
+};
+
+ATTRIBUTE_GROUPS(xeth_port_dev);
+
 static const struct of_device_id xeth_port_of_match[] = {
 	{ .compatible = "xeth,port", },
 	{},
@@ -854,6 +1217,8 @@ struct platform_driver xeth_port_driver = {
 		.name = xeth_port_drvname,
 		.of_match_table = xeth_port_of_match,
 		.groups = xeth_port_groups,
+		.dev_groups = xeth_port_dev_groups,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = xeth_port_probe,
 	.remove = xeth_port_remove,
@@ -43,6 +43,7 @@ void xeth_proxy_dump_ifinfo(struct xeth_proxy *proxy)
 				      xeth_port_ethtool_ksettings(proxy->nd));
 		xeth_sbtx_et_flags(proxy->mux, proxy->xid,
 				   xeth_port_ethtool_priv_flags(proxy->nd));
+		xeth_port_dump_qsfp(proxy->nd);
 	}
 	if (!(proxy->nd->flags & IFF_SLAVE)) {
 		xeth_proxy_dump_ifa(proxy);
@@ -86,7 +87,7 @@ void xeth_proxy_uninit(struct net_device *nd)
 {
 	struct xeth_proxy *proxy = netdev_priv(nd);
 	xeth_sbtx_ifinfo(proxy, 0, XETH_IFINFO_REASON_DEL);
-	xeth_mux_del_proxy(proxy);
+	xeth_mux_unlink_proxy(proxy);
 }
 
 int xeth_proxy_open(struct net_device *nd)
@@ -9,10 +9,29 @@
 
 #include <linux/mutex.h>
 
-static DEFINE_MUTEX(xeth_qsfp_mutex);
+enum {
+	xeth_qsfp_page_sz = 128,
+	/* SFF-8636 free side monitors: temperature through lane 4 tx power */
+	xeth_qsfp_dom_offset = 22,
+	xeth_qsfp_dom_len = 58 - xeth_qsfp_dom_offset,
+};
 
-static void xeth_qsfp_lock(void)	{ mutex_lock(&xeth_qsfp_mutex); }
-static void xeth_qsfp_unlock(void)	{ mutex_unlock(&xeth_qsfp_mutex); }
+/* i2c clientdata of each module; the i2c core serializes transfers per
+ * adapter so @mutex only orders the multi-transfer loads and @page00 fill
+ */
+struct xeth_qsfp {
+	struct mutex mutex;
+	bool cached;
+	/* @id: identifier and revision, bytes 0 and 1 */
+	u8 id[2];
+	/* @page00: static upper page 00h, bytes 128 through 255 */
+	u8 page00[xeth_qsfp_page_sz];
+};
+
+static struct xeth_qsfp *xeth_qsfp_of(struct i2c_client *qsfp)
+{
+	return i2c_get_clientdata(qsfp);
+}
 
 static int xeth_qsfp_peek(struct i2c_adapter *adapter, unsigned short addr)
 {
@@ -39,16 +58,25 @@ static int xeth_qsfp_peek(struct i2c_adapter *adapter, unsigned short addr)
 
 static int xeth_qsfp_bload(struct i2c_client *qsfp, u8 *data, u32 o, u32 n)
 {
-	int i;
-
-	xeth_qsfp_lock();
-	for (i = 0; i < n; i++) {
-		s32 r = i2c_smbus_read_byte_data(qsfp, o + i);
-		if (r < 0)
-			break;
-		data[i] = r;
-	}
-	xeth_qsfp_unlock();
+	int i = 0;
+
+	if (i2c_check_functionality(qsfp->adapter,
+				    I2C_FUNC_SMBUS_READ_I2C_BLOCK))
+		while (i < n) {
+			u8 len = min_t(u32, n - i, I2C_SMBUS_BLOCK_MAX);
+			s32 r = i2c_smbus_read_i2c_block_data(qsfp, o + i,
+							      len, data + i);
+			if (r <= 0)
+				break;
+			i += r;
+		}
+	else
+		for (; i < n; i++) {
+			s32 r = i2c_smbus_read_byte_data(qsfp, o + i);
+			if (r < 0)
+				break;
+			data[i] = r;
+		}
 	return i;
 }
 
@@ -70,11 +98,7 @@ static int xeth_qsfp_xload(struct i2c_client *qsfp, u8 *data, u32 o, u32 n)
 		},
 	};
 	int nmsgs = ARRAY_SIZE(msgs);
-	int err;
-
-	xeth_qsfp_lock();
-	err = i2c_transfer(qsfp->adapter, msgs, nmsgs);
-	xeth_qsfp_unlock();
+	int err = i2c_transfer(qsfp->adapter, msgs, nmsgs);
 
 	return err < 0 ? err : err == nmsgs ? n : 0;
 }
@@ -86,18 +110,102 @@ static int xeth_qsfp_load(struct i2c_client *qsfp, u8 *data, u32 o, u32 n)
 		xeth_qsfp_bload(qsfp, data, o, n);
 }
 
+/* must hold xeth_qsfp mutex */
+static int xeth_qsfp_cache(struct i2c_client *qsfp)
+{
+	struct xeth_qsfp *q = xeth_qsfp_of(qsfp);
+	int n;
+
+	if (q->cached)
+		return 0;
+	n = xeth_qsfp_load(qsfp, q->id, 0, sizeof(q->id));
+	if (n != sizeof(q->id))
+		return n < 0 ? n : -EIO;
+	n = xeth_qsfp_load(qsfp, q->page00, xeth_qsfp_page_sz,
+			   sizeof(q->page00));
+	if (n != sizeof(q->page00))
+		return n < 0 ? n : -EIO;
+	q->cached = true;
+	return 0;
+}
+
+/**
+ * xeth_qsfp_invalidate() - drop the cached static pages
+ * @qsfp: client from xeth_qsfp_client()
+ *
+ * Call on module insertion or removal.
+ */
+void xeth_qsfp_invalidate(struct i2c_client *qsfp)
+{
+	struct xeth_qsfp *q = xeth_qsfp_of(qsfp);
+
+	mutex_lock(&q->mutex);
+	q->cached = false;
+	mutex_unlock(&q->mutex);
+}
+
+static u16 xeth_qsfp_be16(const u8 *b)
+{
+	return (b[0] << 8) | b[1];
+}
+
+/**
+ * xeth_qsfp_read_dom() - sample the digital diagnostic monitors
+ * @qsfp: client from xeth_qsfp_client()
+ * @dom: decoded values
+ *
+ * This is one block read of the lower page; an SFP's monitors are instead
+ * at A2h so it returns -EOPNOTSUPP.
+ */
+int xeth_qsfp_read_dom(struct i2c_client *qsfp, struct xeth_qsfp_dom *dom)
+{
+	struct xeth_qsfp *q = xeth_qsfp_of(qsfp);
+	u8 b[xeth_qsfp_dom_len];
+	int i, n, err;
+
+	mutex_lock(&q->mutex);
+	err = xeth_qsfp_cache(qsfp);
+	if (!err && q->id[0] == 0x03)
+		err = -EOPNOTSUPP;
+	if (!err) {
+		n = xeth_qsfp_load(qsfp, b, xeth_qsfp_dom_offset, sizeof(b));
+		if (n != sizeof(b)) {
+			err = n < 0 ? n : -EIO;
+			q->cached = false;
+		}
+	}
+	mutex_unlock(&q->mutex);
+	if (err)
+		return err;
+
+	/* bytes 22-23 temperature in 1/256 C, 26-27 Vcc in 100 uV, then
+	 * per lane 34-41 rx power and 50-57 tx power in 0.1 uW, and 42-49
+	 * tx bias in 2 uA
+	 */
+	dom->temp_mc = ((s16)xeth_qsfp_be16(&b[0]) * 1000) / 256;
+	dom->vcc_uv = xeth_qsfp_be16(&b[4]) * 100;
+	for (i = 0; i < ARRAY_SIZE(dom->rx_power_nw); i++) {
+		dom->rx_power_nw[i] = xeth_qsfp_be16(&b[12 + (2 * i)]) * 100;
+		dom->tx_bias_ua[i] = xeth_qsfp_be16(&b[20 + (2 * i)]) * 2;
+		dom->tx_power_nw[i] = xeth_qsfp_be16(&b[28 + (2 * i)]) * 100;
+	}
+	return 0;
+}
+
 int xeth_qsfp_get_module_info(struct i2c_client *qsfp,
 			      struct ethtool_modinfo *emi)
 {
+	struct xeth_qsfp *q = xeth_qsfp_of(qsfp);
 	u8 b[2];
-	u32 n = ARRAY_SIZE(b);
 	int err;
 
-	/* Read first 2 bytes to get Module & REV ID */
-	err = xeth_qsfp_load(qsfp, b, 0, n);
+	/* Module & REV ID are the first 2 bytes */
+	mutex_lock(&q->mutex);
+	err = xeth_qsfp_cache(qsfp);
+	memcpy(b, q->id, sizeof(b));
+	mutex_unlock(&q->mutex);
 	if (err < 0)
 		return err;
-	err = 0;
 	switch (b[0]) {
 	case 0x03:	/* SFP    */
 		emi->type = ETH_MODULE_SFF_8472;
@@ -129,14 +237,36 @@ int xeth_qsfp_get_module_info(struct i2c_client *qsfp,
 int xeth_qsfp_get_module_eeprom(struct i2c_client *qsfp,
 				struct ethtool_eeprom *ee, u8 *data)
 {
-	int err;
+	struct xeth_qsfp *q = xeth_qsfp_of(qsfp);
+	u32 i, o, n;
+	int err = 0;
 
 	if (ee->cmd != ETHTOOL_GMODULEEEPROM)
 		return -EOPNOTSUPP;
 	if (!ee->len)
 		return -EINVAL;
-	err = xeth_qsfp_load(qsfp, data, ee->offset, ee->len);
-	return err < 0 ? err : 0;
+	mutex_lock(&q->mutex);
+	for (i = 0; !err && i < ee->len; i += n) {
+		o = ee->offset + i;
+		n = ee->len - i;
+		if (o >= xeth_qsfp_page_sz && o < 2 * xeth_qsfp_page_sz) {
+			n = min_t(u32, n, (2 * xeth_qsfp_page_sz) - o);
+			err = xeth_qsfp_cache(qsfp);
+			if (!err)
+				memcpy(data + i,
+				       q->page00 + o - xeth_qsfp_page_sz, n);
+		} else {
+			if (o < xeth_qsfp_page_sz)
+				n = min_t(u32, n, xeth_qsfp_page_sz - o);
+			err = xeth_qsfp_load(qsfp, data + i, o, n);
+			if (err < 0)
+				q->cached = false;
+			else
+				err = 0;
+		}
+	}
+	mutex_unlock(&q->mutex);
+	return err;
 }
 
 struct i2c_client *xeth_qsfp_client(int nr, const unsigned short * const addrs)
@@ -144,6 +274,7 @@ struct i2c_client *xeth_qsfp_client(int nr, const unsigned short * const addrs)
 	struct i2c_adapter *adapter;
 	struct i2c_board_info info;
 	struct i2c_client *cl;
+	struct xeth_qsfp *q;
 	int id, i;
 
 	memset(&info, 0, sizeof(info));
@@ -159,5 +290,22 @@ struct i2c_client *xeth_qsfp_client(int nr, const unsigned short * const addrs)
 		}
 	}
 	i2c_put_adapter(adapter);
+	if (!cl)
+		return NULL;
+	q = kzalloc(sizeof(*q), GFP_KERNEL);
+	if (!q) {
+		i2c_unregister_device(cl);
+		return NULL;
+	}
+	mutex_init(&q->mutex);
+	i2c_set_clientdata(cl, q);
 	return cl;
 }
+
+void xeth_qsfp_unregister(struct i2c_client *qsfp)
+{
+	struct xeth_qsfp *q = xeth_qsfp_of(qsfp);
+
+	i2c_unregister_device(qsfp);
+	kfree(q);
+}
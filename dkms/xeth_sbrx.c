@@ -20,10 +20,11 @@ static void xeth_sbrx_carrier(struct net_device *mux,
 			      struct xeth_msg_carrier *msg)
 {
 	struct xeth_proxy *proxy = xeth_mux_proxy_of_xid(mux, msg->xid);
-	if (proxy && proxy->kind == XETH_DEV_KIND_PORT)
+	if (proxy && proxy->kind == XETH_DEV_KIND_PORT) {
+		xeth_port_set_carrier_stale(proxy->nd, false);
 		xeth_mux_change_carrier(mux, proxy->nd,
 					msg->flag == XETH_CARRIER_ON);
-	else
+	} else
 		xeth_mux_inc_sbrx_invalid(mux);
 }
 
@@ -50,6 +51,15 @@ static void xeth_sbrx_speed(struct net_device *mux,
 		xeth_port_speed(proxy->nd, msg->mbps);
 }
 
+static void xeth_sbrx_set_encoding(struct net_device *mux,
+				   struct xeth_msg_set_encoding *msg)
+{
+	if (msg->encoding == XETH_MSG_ENCODING_COMPACT)
+		xeth_mux_set_sb_compact(mux);
+	else
+		xeth_mux_clear_sb_compact(mux);
+}
+
 int xeth_sbrx_msg(struct net_device *mux, void *v, size_t n)
 {
 	struct xeth_msg_header *msg = v;
@@ -59,15 +69,36 @@ int xeth_sbrx_msg(struct net_device *mux, void *v, size_t n)
 		return -EINVAL;
 	switch (msg->kind) {
 	case XETH_MSG_KIND_DUMP_IFINFO:
+		xeth_mux_clear_sb_ifinfo_dirty(mux);
+		xeth_mux_reset_all_stats(mux);
+		/* notifiers continue through disconnect to journal changes */
+		if (!xeth_mux_has_netdevice_notifier(mux))
+			xeth_nd_prif_err(mux, xeth_nb_start_netdevice(mux));
+		if (!xeth_mux_has_inetaddr_notifier(mux))
+			xeth_nd_prif_err(mux, xeth_nb_start_inetaddr(mux));
+		/* the mux thread sends the dump in chunks followed by BREAK */
 		xeth_mux_dump_all_ifinfo(mux);
-		xeth_sbtx_break(mux);
-		xeth_nd_prif_err(mux, xeth_nb_start_netdevice(mux));
-		xeth_nd_prif_err(mux, xeth_nb_start_inetaddr(mux));
 		break;
 	case XETH_MSG_KIND_DUMP_FIBINFO:
+		/* restart to redump the fib of each netns */
+		xeth_mux_clear_sb_fibinfo_dirty(mux);
+		xeth_mux_set_sb_dumping(mux);
+		xeth_mux_flush_journal(mux);
+		xeth_nb_stop_all_fib(mux);
 		xeth_nb_start_all_fib(mux);
+		xeth_mux_clear_sb_dumping(mux);
 		xeth_sbtx_break(mux);
-		xeth_nd_prif_err(mux, xeth_nb_start_netevent(mux));
+		if (!xeth_mux_has_netevent_notifier(mux))
+			xeth_nd_prif_err(mux, xeth_nb_start_netevent(mux));
+		xeth_mux_synced(mux);
+		break;
+	case XETH_MSG_KIND_RESYNC:
+		if (n < sizeof(struct xeth_msg_gen))
+			return -EINVAL;
+		xeth_mux_resync(mux, ((struct xeth_msg_gen *)v)->gen);
+		break;
+	case XETH_MSG_KIND_BREAK:
+		xeth_mux_reconcile(mux);
 		break;
 	case XETH_MSG_KIND_CARRIER:
 		xeth_sbrx_carrier(mux, v);
@@ -81,6 +112,11 @@ int xeth_sbrx_msg(struct net_device *mux, void *v, size_t n)
 	case XETH_MSG_KIND_SPEED:
 		xeth_sbrx_speed(mux, v);
 		break;
+	case XETH_MSG_KIND_SET_ENCODING:
+		if (n < sizeof(struct xeth_msg_set_encoding))
+			return -EINVAL;
+		xeth_sbrx_set_encoding(mux, v);
+		break;
 	default:
 		xeth_mux_inc_sbrx_invalid(mux);
 		return -EINVAL;
@@ -19,6 +19,12 @@ static void xeth_sbtx_msg_set(void *data, enum xeth_msg_kind kind)
 	msg->header.kind = kind;
 }
 
+static inline u8 *xeth_sbtx_put(u8 *p, const void *v, size_t n)
+{
+	memcpy(p, v, n);
+	return p + n;
+}
+
 static inline u64 xeth_sbtx_ns_inum(struct net_device *nd)
 {
 	struct net *ndnet = dev_net(nd);
@@ -39,6 +45,20 @@ int xeth_sbtx_break(struct net_device *mux)
 	return 0;
 }
 
+/* Rewrite a dropped message in place to request the given dumps; this never
+ * allocates since it's called within the mux sb lock.
+ */
+void xeth_sbtx_dump_required(struct xeth_sbtxb *sbtxb, u8 dumps)
+{
+	struct xeth_msg_dump_required *msg;
+
+	sbtxb->len = sizeof(*msg);
+	xeth_sbtxb_zero(sbtxb);
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_DUMP_REQUIRED);
+	msg->dumps = dumps;
+}
+
 int xeth_sbtx_change_upper(struct net_device *mux, u32 upper_xid, u32 lower_xid,
 			   bool linking)
 {
@@ -134,17 +154,161 @@ static const char * const xeth_sbtx_fib_event_names[] = {
 	[FIB_EVENT_ENTRY_DEL] "del",
 };
 
+/* Returns the id of the route's nexthop object, or 0 to expand its next hops
+ * in the route message. Resilient groups aren't relayed so these are also
+ * expanded.
+ */
+static u32 xeth_sbtx_nhid(struct nexthop *nh)
+{
+#if defined(nexthop_notifier_info_type)
+	struct nh_group *nhg;
+
+	if (!nh)
+		return 0;
+	if (nh->is_group) {
+		nhg = rcu_dereference_rtnl(nh->nh_grp);
+		if (nhg->resilient)
+			return 0;
+	}
+	return nh->id;
+#else
+	return 0;
+#endif
+}
+
+/* Rather than walk the xid hash for @nd, this finds a proxy by its kind of
+ * device then confirms its hash entry.
+ */
+static bool xeth_sbtx_is_down_proxy(struct net_device *mux,
+				    struct net_device *nd)
+{
+	struct xeth_proxy *proxy;
+
+	if (!nd || (nd->flags & IFF_UP))
+		return false;
+	if (!is_xeth_port(nd) && !is_xeth_vlan(nd) &&
+	    !is_xeth_lag(nd) && !is_xeth_bridge(nd))
+		return false;
+	proxy = netdev_priv(nd);
+	return proxy->mux == mux && proxy->xid &&
+		xeth_mux_proxy_of_xid(mux, proxy->xid) == proxy;
+}
+
+/* A route delete is covered by the FIB_FLUSH_DEV of a down proxy if all of
+ * its next hops are through that one proxy. A route through several down
+ * proxies isn't withdrawn by any of their flushes so its delete is sent.
+ */
+static bool xeth_sbtx_fib_is_covered(struct net_device *mux,
+				     struct fib_info *fi)
+{
+	int i, nhs = fib_info_num_path(fi);
+	struct net_device *nd;
+
+	if (nhs == 0)
+		return false;
+	nd = fib_info_nhc(fi, 0)->nhc_dev;
+	for (i = 1; i < nhs; i++)
+		if (fib_info_nhc(fi, i)->nhc_dev != nd)
+			return false;
+	return xeth_sbtx_is_down_proxy(mux, nd);
+}
+
+/* @arg is the device of the first next hop, initially an ERR_PTR */
+static int xeth_sbtx_fib6_nh_is_other(struct fib6_nh *nh, void *arg)
+{
+	struct net_device **nd = arg;
+
+	if (IS_ERR(*nd))
+		*nd = nh->fib_nh_dev;
+	return nh->fib_nh_dev != *nd;
+}
+
+static bool xeth_sbtx_fib6_is_covered(struct net_device *mux,
+				      struct fib6_info *f6i)
+{
+	struct net_device *nd = ERR_PTR(-ENODEV);
+	struct fib6_info *iter;
+
+	if (f6i->nh) {
+		if (nexthop_for_each_fib6_nh(f6i->nh,
+					     xeth_sbtx_fib6_nh_is_other, &nd) ||
+		    IS_ERR(nd))
+			return false;
+		return xeth_sbtx_is_down_proxy(mux, nd);
+	}
+	nd = f6i->fib6_nh->fib_nh_dev;
+	list_for_each_entry(iter, &f6i->fib6_siblings, fib6_siblings)
+		if (iter->fib6_nh->fib_nh_dev != nd)
+			return false;
+	return xeth_sbtx_is_down_proxy(mux, nd);
+}
+
+static int xeth_sbtx_fib_entry_compact(struct net_device *mux,
+				       struct net *net,
+				       struct fib_entry_notifier_info *feni,
+				       unsigned long event, u32 nhid, int nhs)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_header *msg;
+	__be32 address = htonl(feni->dst);
+	size_t sz = sizeof(*msg) + XETH_SIZEOF_UVARINT64 + 4 + 4 +
+		(3 * XETH_SIZEOF_UVARINT32) +
+		(nhs * ((3 * XETH_SIZEOF_UVARINT32) + 1 + 4));
+	u8 *p;
+	int i;
+
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sz);
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_FIBENTRY_COMPACT);
+	p = (u8 *)(msg + 1);
+	p = xeth_put_uvarint(p, net_eq(net, &init_net) ? 1 : net->ns.inum);
+	*p++ = (u8)event;
+	*p++ = feni->type;
+	*p++ = feni->tos;
+	*p++ = feni->dst_len;
+	p = xeth_sbtx_put(p, &address, DIV_ROUND_UP(feni->dst_len, 8));
+	p = xeth_put_uvarint(p, feni->tb_id);
+	p = xeth_put_uvarint(p, nhid);
+	p = xeth_put_uvarint(p, nhs);
+	rcu_read_lock();
+	for (i = 0; i < nhs; i++) {
+		struct fib_nh_common *nhc = fib_info_nhc(feni->fi, i);
+		p = xeth_put_uvarint(p, nhc->nhc_dev ?
+				     nhc->nhc_dev->ifindex : 0);
+		p = xeth_put_uvarint(p, nhc->nhc_weight);
+		p = xeth_put_uvarint(p, nhc->nhc_flags);
+		*p++ = nhc->nhc_scope;
+		p = xeth_sbtx_put(p, &nhc->nhc_gw.ipv4, 4);
+	}
+	rcu_read_unlock();
+	sbtxb->len = p - (u8 *)msg;
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
 int xeth_sbtx_fib_entry(struct net_device *mux, struct net *net,
 			struct fib_entry_notifier_info *feni,
 			unsigned long event)
 {
 	int i, nhs;
+	u32 nhid;
 	struct xeth_sbtxb *sbtxb;
 	struct xeth_next_hop *nh;
 	struct xeth_msg_fibentry *msg;
 	size_t n = sizeof(*msg);
 
-	nhs = fib_info_num_path(feni->fi);
+	if (event == FIB_EVENT_ENTRY_DEL &&
+	    xeth_sbtx_fib_is_covered(mux, feni->fi)) {
+		xeth_mux_inc_sbtx_fib_covered(mux);
+		return 0;
+	}
+	nhid = xeth_sbtx_nhid(feni->fi->nh);
+	nhs = nhid ? 0 : fib_info_num_path(feni->fi);
+	if (xeth_mux_has_sb_compact(mux))
+		return xeth_sbtx_fib_entry_compact(mux, net, feni, event,
+						   nhid, nhs);
 	if (nhs > 0)
 		n += (nhs * sizeof(struct xeth_next_hop));
 	sbtxb = xeth_mux_alloc_sbtxb(mux, n);
@@ -161,6 +325,7 @@ int xeth_sbtx_fib_entry(struct net_device *mux, struct net *net,
 	msg->tos = feni->tos;
 	msg->type = feni->type;
 	msg->table = feni->tb_id;
+	msg->nhid = nhid;
 	rcu_read_lock();
 	for(i = 0; i < msg->nhs; i++) {
 		struct fib_nh_common *nhc = fib_info_nhc(feni->fi, i);
@@ -178,6 +343,95 @@ int xeth_sbtx_fib_entry(struct net_device *mux, struct net *net,
 	return 0;
 }
 
+static u8 *xeth_sbtx_put_nh6(u8 *p, const struct fib6_nh *nh)
+{
+	p = xeth_put_uvarint(p, nh->fib_nh_dev ? nh->fib_nh_dev->ifindex : 0);
+	p = xeth_put_uvarint(p, nh->fib_nh_weight);
+	p = xeth_put_uvarint(p, nh->fib_nh_flags);
+	if (nh->fib_nh_gw_family == AF_INET6) {
+		*p++ = 16;
+		p = xeth_sbtx_put(p, &nh->fib_nh_gw6, 16);
+	} else {
+		*p++ = 0;
+	}
+	return p;
+}
+
+struct xeth_sbtx_nh6_arg {
+	u8 *p;
+	size_t n;
+};
+
+static int xeth_sbtx_fib6_nh_count(struct fib6_nh *nh, void *v)
+{
+	struct xeth_sbtx_nh6_arg *arg = v;
+	arg->n++;
+	return 0;
+}
+
+static int xeth_sbtx_fib6_nh_put(struct fib6_nh *nh, void *v)
+{
+	struct xeth_sbtx_nh6_arg *arg = v;
+	arg->p = xeth_sbtx_put_nh6(arg->p, nh);
+	return 0;
+}
+
+static int xeth_sbtx_fib6_entry_compact(struct net_device *mux,
+					struct net *net,
+					struct fib6_info *f6i,
+					unsigned long event)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_header *msg;
+	struct fib6_info *iter;
+	struct xeth_sbtx_nh6_arg arg = { .n = 0 };
+	u32 nhid = xeth_sbtx_nhid(f6i->nh);
+	u8 plen = f6i->fib6_dst.plen;
+	size_t sz;
+
+	if (nhid) {
+		arg.n = 0;
+	} else if (f6i->nh) {
+		nexthop_for_each_fib6_nh(f6i->nh, xeth_sbtx_fib6_nh_count,
+					 &arg);
+	} else {
+		arg.n = 1;
+		list_for_each_entry(iter, &f6i->fib6_siblings, fib6_siblings)
+			arg.n++;
+	}
+	sz = sizeof(*msg) + XETH_SIZEOF_UVARINT64 + 3 + 16 +
+		(3 * XETH_SIZEOF_UVARINT32) +
+		(arg.n * ((3 * XETH_SIZEOF_UVARINT32) + 1 + 16));
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sz);
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_FIB6ENTRY_COMPACT);
+	arg.p = (u8 *)(msg + 1);
+	arg.p = xeth_put_uvarint(arg.p,
+				 net_eq(net, &init_net) ? 1 : net->ns.inum);
+	*arg.p++ = (u8)event;
+	*arg.p++ = f6i->fib6_type;
+	*arg.p++ = plen;
+	arg.p = xeth_sbtx_put(arg.p, &f6i->fib6_dst.addr,
+			      DIV_ROUND_UP(plen, 8));
+	arg.p = xeth_put_uvarint(arg.p, f6i->fib6_table->tb6_id);
+	arg.p = xeth_put_uvarint(arg.p, nhid);
+	arg.p = xeth_put_uvarint(arg.p, arg.n);
+	if (nhid) {
+		/* refer to the nexthop object */
+	} else if (f6i->nh) {
+		nexthop_for_each_fib6_nh(f6i->nh, xeth_sbtx_fib6_nh_put, &arg);
+	} else {
+		arg.p = xeth_sbtx_put_nh6(arg.p, f6i->fib6_nh);
+		list_for_each_entry(iter, &f6i->fib6_siblings, fib6_siblings)
+			arg.p = xeth_sbtx_put_nh6(arg.p, iter->fib6_nh);
+	}
+	sbtxb->len = arg.p - (u8 *)msg;
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
 int xeth_sbtx_fib6_nh_entry(struct net_device *mux, struct net *net,
 			    struct fib6_entry_notifier_info *feni,
 			    struct fib6_info *f6i, unsigned long event)
@@ -190,8 +444,9 @@ int xeth_sbtx_fib6_nh_entry(struct net_device *mux, struct net *net,
 	struct nh_info *nhi;
 	struct fib_nh_common *nhc;
 	size_t i, sz = sizeof(*msg), nsiblings = 0;
+	u32 nhid = xeth_sbtx_nhid(f6i->nh);
 
-	if (f6i->nh->is_group) {
+	if (!nhid && f6i->nh->is_group) {
 		nhg = rcu_dereference_rtnl(f6i->nh->nh_grp);
 		if (nhg->mpath) {
 			if (nhg->num_nh > 0) {
@@ -212,7 +467,9 @@ int xeth_sbtx_fib6_nh_entry(struct net_device *mux, struct net *net,
 	msg->nsiblings = nsiblings;
 	msg->type = f6i->fib6_type;
 	msg->table = f6i->fib6_table->tb6_id;
-	if (f6i->nh->is_group) {
+	if (nhid) {
+		msg->nhid = nhid;
+	} else if (f6i->nh->is_group) {
 		for (i = 0, sibling = &msg->siblings[0]; i < nhg->num_nh; i++) {
 			nhge = &nhg->nh_entries[i];
 			nhi = rcu_dereference_rtnl(nhge->nh->nh_info);
@@ -260,11 +517,17 @@ int xeth_sbtx_fib6_entry(struct net_device *mux, struct net *net,
 
 	if (IS_ERR(f6i))
 		return PTR_ERR(f6i);
+	if (event == FIB_EVENT_ENTRY_DEL && xeth_sbtx_fib6_is_covered(mux, f6i)) {
+		xeth_mux_inc_sbtx_fib_covered(mux);
+		return 0;
+	}
+	if (xeth_mux_has_sb_compact(mux))
+		return xeth_sbtx_fib6_entry_compact(mux, net, f6i, event);
 	if (f6i->nh)
 		return xeth_sbtx_fib6_nh_entry(mux, net, feni, f6i, event);
 	nsiblings = f6i->fib6_nsiblings;
 	if (nsiblings > 0)
-		sz += nsiblings * sizeof(struct xeth_next_hop6 *);
+		sz += nsiblings * sizeof(struct xeth_next_hop6);
 	sbtxb = xeth_mux_alloc_sbtxb(mux, sz);
 	if (!sbtxb)
 		return -ENOMEM;
@@ -307,6 +570,55 @@ int xeth_sbtx_fib6_entry(struct net_device *mux, struct net *net,
 	return 0;
 }
 
+int xeth_sbtx_fib_flush(struct net_device *mux, struct net *net, u32 table)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_fib_flush *msg;
+
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sizeof(*msg));
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_FIB_FLUSH);
+	msg->net = net_eq(net, &init_net) ? 1 : net->ns.inum;
+	msg->table = table;
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
+int xeth_sbtx_fib_flush_dev(struct xeth_proxy *proxy)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_fib_flush_dev *msg;
+
+	sbtxb = xeth_mux_alloc_sbtxb(proxy->mux, sizeof(*msg));
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_FIB_FLUSH_DEV);
+	msg->net = xeth_sbtx_ns_inum(proxy->nd);
+	msg->ifindex = proxy->nd->ifindex;
+	msg->xid = proxy->xid;
+	xeth_mux_queue_sbtx(proxy->mux, sbtxb);
+	return 0;
+}
+
+/* @kind: XETH_MSG_KIND_GEN or XETH_MSG_KIND_RESYNC */
+int xeth_sbtx_gen(struct net_device *mux, enum xeth_msg_kind kind, u64 gen)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_gen *msg;
+
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sizeof(*msg));
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, kind);
+	msg->gen = gen;
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
 int xeth_sbtx_ifa(struct net_device *mux, struct in_ifaddr *ifa,
 		  unsigned long event, u32 xid)
 {
@@ -386,11 +698,53 @@ int xeth_sbtx_ifinfo(struct xeth_proxy *proxy, unsigned iff,
 	return 0;
 }
 
+static int xeth_sbtx_neigh_update_compact(struct net_device *mux,
+					  struct neighbour *neigh)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_header *msg;
+	char ha[MAX_ADDR_LEN];
+	bool valid = false;
+	u8 *p;
+
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sizeof(*msg) +
+				     XETH_SIZEOF_UVARINT64 +
+				     XETH_SIZEOF_UVARINT32 + 2 +
+				     neigh->tbl->key_len + 1 + ETH_ALEN);
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_NEIGH_UPDATE_COMPACT);
+	p = (u8 *)(msg + 1);
+	p = xeth_put_uvarint(p, xeth_sbtx_ns_inum(neigh->dev));
+	p = xeth_put_uvarint(p, neigh->dev->ifindex);
+	*p++ = neigh->ops->family;
+	*p++ = neigh->tbl->key_len;
+	p = xeth_sbtx_put(p, neigh->primary_key, neigh->tbl->key_len);
+	read_lock_bh(&neigh->lock);
+	if ((neigh->nud_state & NUD_VALID) && !neigh->dead) {
+		neigh_ha_snapshot(ha, neigh, neigh->dev);
+		valid = (neigh->nud_state & NUD_VALID) && !neigh->dead;
+	}
+	read_unlock_bh(&neigh->lock);
+	if (valid) {
+		*p++ = ETH_ALEN;
+		p = xeth_sbtx_put(p, ha, ETH_ALEN);
+	} else {
+		*p++ = 0;
+	}
+	sbtxb->len = p - (u8 *)msg;
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
 int xeth_sbtx_neigh_update(struct net_device *mux, struct neighbour *neigh)
 {
 	struct xeth_sbtxb *sbtxb;
 	struct xeth_msg_neigh_update *msg;
 
+	if (xeth_mux_has_sb_compact(mux))
+		return xeth_sbtx_neigh_update_compact(mux, neigh);
 	sbtxb = xeth_mux_alloc_sbtxb(mux, sizeof(*msg));
 	if (!sbtxb)
 		return -ENOMEM;
@@ -429,3 +783,109 @@ int xeth_sbtx_netns(struct net_device *mux, u64 ns_inum, bool add)
 	xeth_mux_queue_sbtx(mux, sbtxb);
 	return 0;
 }
+
+int xeth_sbtx_qsfp(struct net_device *mux, u32 xid, enum xeth_qsfp_event event)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_qsfp *msg;
+
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sizeof(*msg));
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_QSFP);
+	msg->xid = xid;
+	msg->event = event;
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
+#if defined(nexthop_notifier_info_type)
+
+static int xeth_sbtx_nexthop_single(struct net_device *mux, struct net *net,
+				    u32 id, struct nh_notifier_single_info *nh,
+				    enum xeth_nexthop_event event)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_nexthop *msg;
+
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sizeof(*msg));
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_NEXTHOP);
+	msg->net = net_eq(net, &init_net) ? 1 : net->ns.inum;
+	msg->id = id;
+	msg->event = event;
+	msg->family = nh->gw_family;
+	if (nh->is_reject)
+		msg->flags |= 1 << XETH_NEXTHOP_FLAG_REJECT_BIT;
+	if (nh->is_fdb)
+		msg->flags |= 1 << XETH_NEXTHOP_FLAG_FDB_BIT;
+	if (nh->has_encap)
+		msg->flags |= 1 << XETH_NEXTHOP_FLAG_ENCAP_BIT;
+	msg->ifindex = nh->dev ? nh->dev->ifindex : 0;
+	switch (nh->gw_family) {
+	case AF_INET:
+		memcpy(msg->gw, &nh->ipv4, 4);
+		break;
+	case AF_INET6:
+		memcpy(msg->gw, &nh->ipv6, 16);
+		break;
+	}
+	no_xeth_debug("nexthop %u event %u dev %d", id, event, msg->ifindex);
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
+static int xeth_sbtx_nexthop_group(struct net_device *mux, struct net *net,
+				   u32 id, struct nh_notifier_grp_info *grp,
+				   enum xeth_nexthop_event event)
+{
+	struct xeth_sbtxb *sbtxb;
+	struct xeth_msg_nexthop_group *msg;
+	size_t i, n, sz = sizeof(*msg);
+
+	n = event == XETH_NEXTHOP_EVENT_DEL ? 0 : grp->num_nh;
+	sz += n * sizeof(struct xeth_nexthop_group_entry);
+	sbtxb = xeth_mux_alloc_sbtxb(mux, sz);
+	if (!sbtxb)
+		return -ENOMEM;
+	msg = xeth_sbtxb_data(sbtxb);
+	xeth_sbtx_msg_set(msg, XETH_MSG_KIND_NEXTHOP_GROUP);
+	msg->net = net_eq(net, &init_net) ? 1 : net->ns.inum;
+	msg->id = id;
+	msg->event = event;
+	if (grp->is_fdb)
+		msg->flags |= 1 << XETH_NEXTHOP_FLAG_FDB_BIT;
+	msg->n = n;
+	for (i = 0; i < n; i++) {
+		msg->nh[i].id = grp->nh_entries[i].id;
+		msg->nh[i].weight = grp->nh_entries[i].weight;
+	}
+	no_xeth_debug("nexthop group %u event %u w/ %zd nexthop(s)",
+		      id, event, n);
+	xeth_mux_queue_sbtx(mux, sbtxb);
+	return 0;
+}
+
+/* Routes refer to the relayed nexthop objects by id; resilient groups are
+ * ignored here and instead expanded in each route that uses them.
+ */
+int xeth_sbtx_nexthop(struct net_device *mux, struct net *net,
+		      struct nh_notifier_info *info,
+		      enum xeth_nexthop_event event)
+{
+	switch (info->type) {
+	case NH_NOTIFIER_INFO_TYPE_SINGLE:
+		return xeth_sbtx_nexthop_single(mux, net, info->id, info->nh,
+						event);
+	case NH_NOTIFIER_INFO_TYPE_GRP:
+		return xeth_sbtx_nexthop_group(mux, net, info->id,
+					       info->nh_grp, event);
+	default:
+		return 0;
+	}
+}
+
+#endif /* nexthop_notifier_info_type */
@@ -71,7 +71,16 @@ static inline bool xeth_vlan_tci_is_exception(uint16_t tci)
 #endif
 
 enum xeth_msg_version {
-	XETH_MSG_VERSION = 2,
+	XETH_MSG_VERSION = 3,
+};
+
+/* The daemon may request the compact encoding with SET_ENCODING; thereafter,
+ * until disconnect, the mux sends FIBENTRY_COMPACT, FIB6ENTRY_COMPACT, and
+ * NEIGH_UPDATE_COMPACT in place of the fixed messages.
+ */
+enum xeth_msg_encoding {
+	XETH_MSG_ENCODING_FIXED,
+	XETH_MSG_ENCODING_COMPACT,
 };
 
 enum {
@@ -81,8 +90,50 @@ enum {
 enum xeth_encap {
 	XETH_ENCAP_VLAN = 0,
 	XETH_ENCAP_VPLS,
+	/* VLAN encapsulated except trapped frames which have xeth_trap_hdr */
+	XETH_ENCAP_TRAP,
+};
+
+enum {
+	/* IEEE 802 local experimental ethertype 1 */
+	XETH_ETH_P_TRAP = 0x88b5,
 };
 
+enum xeth_trap_reason {
+	XETH_TRAP_REASON_UNSPEC,
+	XETH_TRAP_REASON_L2_CONTROL,
+	XETH_TRAP_REASON_ARP,
+	XETH_TRAP_REASON_ND,
+	XETH_TRAP_REASON_TTL,
+	XETH_TRAP_REASON_BGP,
+	XETH_TRAP_REASON_BFD,
+	XETH_TRAP_REASON_ROUTE_MISS,
+	XETH_TRAP_REASON_NEIGH_MISS,
+	XETH_TRAP_REASON_MTU,
+	XETH_TRAP_REASON_ACL,
+};
+
+enum xeth_trap_flag_bit {
+	XETH_TRAP_FLAG_TSTAMP_BIT,
+};
+
+/* A trapped frame has this header, in network order, after an
+ * XETH_ETH_P_TRAP ethertype that displaces its own to @proto. The header
+ * size keeps the network header of a NET_IP_ALIGN'd frame on a four byte
+ * boundary.
+ */
+struct xeth_trap_hdr {
+	uint32_t xid;
+	uint16_t reason;
+	/* @prio: receive priority, 0 through XETH_VLAN_PRIO_MAX */
+	uint8_t prio;
+	uint8_t flags;
+	/* @tstamp: ingress nanoseconds if flags has XETH_TRAP_FLAG_TSTAMP_BIT */
+	uint64_t tstamp;
+	uint8_t pad[2];
+	uint16_t proto;
+} __attribute__((packed));
+
 enum xeth_encap_vid_bit {
       XETH_ENCAP_VLAN_VID_BIT = 12,
       XETH_ENCAP_VPLS_VID_BIT = 20,
@@ -102,6 +153,13 @@ enum xeth_port_ifla {
 enum xeth_vlan_ifla {
 	XETH_VLAN_IFLA_UNSPEC,
 	XETH_VLAN_IFLA_VID,	/* u16 */
+	/* @XETH_VLAN_IFLA_VID_LAST: also create VID+1 through this VID */
+	XETH_VLAN_IFLA_VID_LAST,	/* u16 */
+	/* @XETH_VLAN_IFLA_NAME_FMT: name of each additional VID with
+	 * a single "%u"; otherwise, the IFLA_IFNAME through its last '.'
+	 * followed by the VID
+	 */
+	XETH_VLAN_IFLA_NAME_FMT,	/* string */
 	XETH_VLAN_N_IFLA,
 };
 
@@ -148,6 +206,18 @@ enum xeth_msg_kind {
 	XETH_MSG_KIND_CHANGE_UPPER_XID,
 	XETH_MSG_KIND_NETNS_ADD,
 	XETH_MSG_KIND_NETNS_DEL,
+	XETH_MSG_KIND_NEXTHOP,
+	XETH_MSG_KIND_NEXTHOP_GROUP,
+	XETH_MSG_KIND_FIB_FLUSH,
+	XETH_MSG_KIND_FIB_FLUSH_DEV,
+	XETH_MSG_KIND_SET_ENCODING,
+	XETH_MSG_KIND_FIBENTRY_COMPACT,
+	XETH_MSG_KIND_FIB6ENTRY_COMPACT,
+	XETH_MSG_KIND_NEIGH_UPDATE_COMPACT,
+	XETH_MSG_KIND_GEN,
+	XETH_MSG_KIND_RESYNC,
+	XETH_MSG_KIND_DUMP_REQUIRED,
+	XETH_MSG_KIND_QSFP,
 };
 
 enum xeth_link_stat {
@@ -198,6 +268,17 @@ enum xeth_msg_ifinfo_feature_bits {
 	XETH_IFINFO_FEATURE_L2_FWD_OFFLOAD_BIT
 };
 
+enum xeth_nexthop_event {
+	XETH_NEXTHOP_EVENT_REPLACE,
+	XETH_NEXTHOP_EVENT_DEL,
+};
+
+enum xeth_nexthop_flag_bits {
+	XETH_NEXTHOP_FLAG_REJECT_BIT,
+	XETH_NEXTHOP_FLAG_FDB_BIT,
+	XETH_NEXTHOP_FLAG_ENCAP_BIT,
+};
+
 struct xeth_msg_header {
 	uint64_t z64;
 	uint32_t z32;
@@ -241,6 +322,37 @@ static inline void xeth_msg_init(void *data, enum xeth_msg_kind kind)
 	msg->header.kind = kind;
 }
 
+/* Compact messages follow the header with these fields, where uv is an
+ * unsigned LEB128 varint and the prefix has (length + 7) / 8 bytes.
+ *
+ * FIBENTRY_COMPACT:
+ *	uv net, u8 event, u8 type, u8 tos, u8 length, prefix,
+ *	uv table, uv nhid, uv nhs,
+ *	nhs * { uv ifindex, uv weight, uv flags, u8 scope, be32 gw }
+ * FIB6ENTRY_COMPACT:
+ *	uv net, u8 event, u8 type, u8 length, prefix,
+ *	uv table, uv nhid, uv nhs,
+ *	nhs * { uv ifindex, uv weight, uv flags, u8 gwlen, u8 gw[gwlen] }
+ * NEIGH_UPDATE_COMPACT:
+ *	uv net, uv ifindex, u8 family, u8 len, u8 dst[len],
+ *	u8 lladdrlen, u8 lladdr[lladdrlen]
+ *
+ * A FIB6ENTRY_COMPACT gwlen is 0 or 16; a NEIGH_UPDATE_COMPACT lladdrlen of 0
+ * indicates an invalid or dead neighbor.
+ */
+enum {
+	XETH_SIZEOF_UVARINT32 = 5,
+	XETH_SIZEOF_UVARINT64 = 10,
+};
+
+static inline uint8_t *xeth_put_uvarint(uint8_t *p, uint64_t v)
+{
+	for (; v >= 0x80; v >>= 7)
+		*p++ = (uint8_t)v | 0x80;
+	*p++ = (uint8_t)v;
+	return p;
+}
+
 struct xeth_msg_break {
 	struct xeth_msg_header header;
 };
@@ -315,9 +427,32 @@ struct xeth_msg_fibentry {
 	uint8_t tos;
 	uint8_t type;
 	uint32_t table;
+	/* @nhid: if non-zero, the route refers to this NEXTHOP or
+	 * NEXTHOP_GROUP object instead of listing @nhs next hops
+	 */
+	uint32_t nhid;
+	uint32_t reserved;
 	struct xeth_next_hop nh[];
 };
 
+/* @table: of the flushed routes; RT_TABLE_UNSPEC (0) for all tables */
+struct xeth_msg_fib_flush {
+	struct xeth_msg_header header;
+	uint64_t net;
+	uint32_t table;
+	uint32_t reserved;
+};
+
+/* withdraws the routes w/ all next hops through @ifindex; the respective
+ * FIBENTRY and FIB6ENTRY deletes aren't sent
+ */
+struct xeth_msg_fib_flush_dev {
+	struct xeth_msg_header header;
+	uint64_t net;
+	int32_t ifindex;
+	uint32_t xid;
+};
+
 struct xeth_next_hop6 {
 	int32_t ifindex;
 	int32_t weight;
@@ -335,10 +470,58 @@ struct xeth_msg_fib6entry {
 	uint8_t nsiblings;
 	uint8_t type;
 	uint32_t table;
+	/* @nhid: if non-zero, the route refers to this NEXTHOP or
+	 * NEXTHOP_GROUP object and @nh is zero w/o siblings
+	 */
+	uint32_t nhid;
+	uint32_t reserved;
 	struct xeth_next_hop6 nh;
 	struct xeth_next_hop6 siblings[];
 };
 
+/* The mux numbers each journaled message with a generation then, once synced
+ * by DUMP_FIBINFO or RESYNC, sends GEN with that of the last message sent
+ * whenever its queue empties. A reconnecting switch may RESYNC with the last
+ * GEN that it received; the mux replies with the journaled messages since
+ * then and a BREAK, or, if those are no longer available, a RESYNC with gen 0
+ * to indicate that it must DUMP_IFINFO and DUMP_FIBINFO instead.
+ */
+struct xeth_msg_gen {
+	struct xeth_msg_header header;
+	uint64_t gen;
+};
+
+enum xeth_msg_dump_bits {
+	XETH_MSG_DUMP_IFINFO_BIT,
+	XETH_MSG_DUMP_FIBINFO_BIT,
+};
+
+/* After its tx queue exceeds the configured depth or size, the mux drops
+ * subsequent interface or forwarding updates and sends this message once
+ * for each class; the switch should then request the indicated dumps.
+ */
+struct xeth_msg_dump_required {
+	struct xeth_msg_header header;
+	uint8_t dumps;	/* (1 << XETH_MSG_DUMP_*_BIT) */
+	uint8_t pad[7];
+};
+
+enum xeth_qsfp_event {
+	XETH_QSFP_EVENT_REMOVED,
+	XETH_QSFP_EVENT_INSERTED,
+	XETH_QSFP_EVENT_INTERRUPT,
+};
+
+/* Sent by the port on module insertion, removal, or IntL assertion, and
+ * with its ifinfo dump to report whether a module is present.
+ */
+struct xeth_msg_qsfp {
+	struct xeth_msg_header header;
+	uint32_t xid;
+	uint8_t event;	/* enum xeth_qsfp_event */
+	uint8_t pad[3];
+};
+
 struct xeth_msg_ifa {
 	struct xeth_msg_header header;
 	uint32_t xid;
@@ -391,6 +574,41 @@ struct xeth_msg_netns {
 	uint64_t net;
 };
 
+/* @family is that of @gw: AF_INET, AF_INET6, or 0 w/o gateway */
+struct xeth_msg_nexthop {
+	struct xeth_msg_header header;
+	uint64_t net;
+	uint32_t id;
+	uint8_t event;
+	uint8_t family;
+	uint8_t flags;
+	uint8_t pad;
+	int32_t ifindex;
+	uint32_t reserved;
+	uint8_t gw[16];
+};
+
+struct xeth_nexthop_group_entry {
+	uint32_t id;
+	uint32_t weight;
+};
+
+struct xeth_msg_nexthop_group {
+	struct xeth_msg_header header;
+	uint64_t net;
+	uint32_t id;
+	uint8_t event;
+	uint8_t flags;
+	uint16_t n;
+	struct xeth_nexthop_group_entry nh[];
+};
+
+struct xeth_msg_set_encoding {
+	struct xeth_msg_header header;
+	uint8_t encoding;
+	uint8_t pad[7];
+};
+
 struct xeth_msg_speed {
 	struct xeth_msg_header header;
 	uint32_t xid;
@@ -14,11 +14,10 @@ struct xeth_vlan_priv {
 	struct net_device *link;
 };
 
-bool xeth_vlan_has_link(const struct net_device *nd,
-			const struct net_device *link)
+struct net_device *xeth_vlan_link(const struct net_device *nd)
 {
 	struct xeth_vlan_priv *priv = netdev_priv(nd);
-	return priv->link == link;
+	return priv->link;
 }
 
 static int xeth_vlan_get_iflink(const struct net_device *nd)
@@ -129,36 +128,129 @@ static int xeth_vlan_validate(struct nlattr *tb[], struct nlattr *data[],
 			return -ERANGE;
 		}
 	}
+	if (data && data[XETH_VLAN_IFLA_VID_LAST]) {
+		u16 last = nla_get_u16(data[XETH_VLAN_IFLA_VID_LAST]);
+		if (!data[XETH_VLAN_IFLA_VID]) {
+			NL_SET_ERR_MSG(extack, "VID range without first VID");
+			return -EINVAL;
+		}
+		if (last < nla_get_u16(data[XETH_VLAN_IFLA_VID]) ||
+		    last >= VLAN_N_VID) {
+			NL_SET_ERR_MSG(extack, "out-of-range last VID");
+			return -ERANGE;
+		}
+	}
+	if (data && data[XETH_VLAN_IFLA_NAME_FMT]) {
+		const char *fmt = nla_data(data[XETH_VLAN_IFLA_NAME_FMT]);
+		const char *pct = strchr(fmt, '%');
+		if (!pct || pct[1] != 'u' || strchr(pct + 1, '%')) {
+			NL_SET_ERR_MSG(extack, "name format needs one %u");
+			return -EINVAL;
+		}
+	}
 	return 0;
 }
 
+/* Assign the xid and link then register a VLAN proxy; the caller sends its
+ * IFINFO NEW.
+ */
+static int xeth_vlan_register(struct net_device *nd, struct net_device *link,
+			      u16 vid)
+{
+	struct xeth_vlan_priv *priv = netdev_priv(nd);
+	struct xeth_proxy *proxy = netdev_priv(link);
+	int err;
+
+	priv->proxy.nd = nd;
+	priv->link = link;
+
+	eth_hw_addr_inherit(nd, link);
+	nd->addr_assign_type = NET_ADDR_STOLEN;
+
+	priv->proxy.mux = proxy->mux;
+	priv->proxy.xid = proxy->xid;
+
+	switch (xeth_mux_encap(proxy->mux)) {
+	case XETH_ENCAP_VLAN:
+		priv->proxy.xid |= ((u32)vid << XETH_ENCAP_VLAN_VID_BIT);
+		break;
+	case XETH_ENCAP_VPLS:
+		priv->proxy.xid |= ((u32)vid << XETH_ENCAP_VPLS_VID_BIT);
+		break;
+	}
+
+	nd->min_mtu = link->min_mtu;
+	nd->max_mtu = link->max_mtu;
+
+	xeth_mux_add_proxy(&priv->proxy);
+
+	err = register_netdevice(nd);
+	if (err)
+		xeth_mux_del_proxy(&priv->proxy);
+	return err;
+}
+
+/* Create and register the VLAN proxies of @first+1 through @last with the
+ * same RTNL hold as the @first; returns the number created.
+ */
+static u16 xeth_vlan_new_range(struct net_device *first, struct nlattr *fmt,
+			       u16 vid, u16 last)
+{
+	struct xeth_vlan_priv *priv = netdev_priv(first);
+	const char *dot = strrchr(first->name, '.');
+	int prefix = dot ? dot - first->name : strlen(first->name);
+	char name[IFNAMSIZ];
+	struct net_device *nd;
+	u16 n = 0;
+	int err;
+
+	while (vid++ < last) {
+		if (fmt)
+			scnprintf(name, IFNAMSIZ, nla_data(fmt), vid);
+		else
+			scnprintf(name, IFNAMSIZ, "%.*s.%u",
+				  prefix, first->name, vid);
+		nd = alloc_netdev(sizeof(struct xeth_vlan_priv), name,
+				  NET_NAME_USER, xeth_vlan_setup);
+		if (!nd) {
+			xeth_nd_err(first, "%s: no memory", name);
+			break;
+		}
+		dev_net_set(nd, dev_net(first));
+		err = xeth_vlan_register(nd, priv->link, vid);
+		if (err) {
+			xeth_nd_err(first, "%s: %d", name, err);
+			free_netdev(nd);
+			break;
+		}
+		xeth_sbtx_ifinfo(netdev_priv(nd), 0, XETH_IFINFO_REASON_NEW);
+		n++;
+	}
+	return n;
+}
+
 static int xeth_vlan_newlink(struct net *src_net, struct net_device *nd,
 			     struct nlattr *tb[], struct nlattr *data[],
 			     struct netlink_ext_ack *extack)
 {
 	struct xeth_vlan_priv *priv = netdev_priv(nd);
-	struct xeth_proxy *proxy;
+	struct net_device *link;
 	int i, err;
-	u16 vid;
-
-	priv->proxy.nd = nd;
+	u16 vid = 0, last, n;
 
 	rcu_read_lock();
-	priv->link =
-		dev_get_by_index_rcu(dev_net(nd), nla_get_u32(tb[IFLA_LINK]));
+	link = dev_get_by_index_rcu(dev_net(nd), nla_get_u32(tb[IFLA_LINK]));
 	rcu_read_unlock();
 
-	if (IS_ERR_OR_NULL(priv->link)) {
+	if (IS_ERR_OR_NULL(link)) {
 		NL_SET_ERR_MSG(extack, "unkown link");
-		return PTR_ERR(priv->link);
+		return PTR_ERR(link);
 	}
-	if (!is_xeth_port(priv->link) && !is_xeth_lag(priv->link)) {
+	if (!is_xeth_port(link) && !is_xeth_lag(link)) {
 		NL_SET_ERR_MSG(extack, "link not an xeth port or lag");
 		return -EINVAL;
 	}
 
-	proxy = netdev_priv(priv->link);
-
 	if (data && data[XETH_VLAN_IFLA_VID])
 		vid  = nla_get_u16(data[XETH_VLAN_IFLA_VID]);
 	else
@@ -180,32 +272,18 @@ static int xeth_vlan_newlink(struct net *src_net, struct net_device *nd,
 		return -ERANGE;
 	}
 
-	eth_hw_addr_inherit(nd, priv->link);
-	nd->addr_assign_type = NET_ADDR_STOLEN;
-
-	priv->proxy.mux = proxy->mux;
-	priv->proxy.xid = proxy->xid;
-
-	switch (xeth_mux_encap(proxy->mux)) {
-	case XETH_ENCAP_VLAN:
-		priv->proxy.xid |= ((u32)vid << XETH_ENCAP_VLAN_VID_BIT);
-		break;
-	case XETH_ENCAP_VPLS:
-		priv->proxy.xid |= ((u32)vid << XETH_ENCAP_VPLS_VID_BIT);
-		break;
-	}
-
-	nd->min_mtu = priv->link->min_mtu;
-	nd->max_mtu = priv->link->max_mtu;
-
-	xeth_mux_add_proxy(&priv->proxy);
-
-	err = register_netdevice(nd);
-	if (!err)
-		err = xeth_sbtx_ifinfo(&priv->proxy, 0, XETH_IFINFO_REASON_NEW);
+	err = xeth_vlan_register(nd, link, vid);
 	if (err)
-		xeth_mux_del_proxy(&priv->proxy);
-	return err;
+		return err;
+	err = xeth_sbtx_ifinfo(&priv->proxy, 0, XETH_IFINFO_REASON_NEW);
+	if (err || !data || !data[XETH_VLAN_IFLA_VID_LAST])
+		return err;
+
+	last = nla_get_u16(data[XETH_VLAN_IFLA_VID_LAST]);
+	n = xeth_vlan_new_range(nd, data[XETH_VLAN_IFLA_NAME_FMT], vid, last);
+	if (n < last - vid)
+		NL_SET_ERR_MSG(extack, "incomplete VID range");
+	return 0;
 }
 
 static void xeth_vlan_dellink(struct net_device *nd, struct list_head *q)
@@ -225,6 +303,9 @@ static struct net *xeth_vlan_get_link_net(const struct net_device *nd)
 
 static const struct nla_policy xeth_vlan_nla_policy[XETH_VLAN_N_IFLA] = {
 	[XETH_VLAN_IFLA_VID] = { .type = NLA_U16 },
+	[XETH_VLAN_IFLA_VID_LAST] = { .type = NLA_U16 },
+	[XETH_VLAN_IFLA_NAME_FMT] = { .type = NLA_NUL_STRING,
+				      .len = IFNAMSIZ - 1 },
 };
 
 struct rtnl_link_ops xeth_vlan_lnko = {
@@ -37,6 +37,17 @@ const (
 	ETH_C_VLAN_PAYLOAD
 )
 
+// xeth_trap_hdr that follows the EthPTrap ethertype
+const (
+	ETH_TRAP_XID     = ETH_PAYLOAD
+	ETH_TRAP_REASON  = ETH_TRAP_XID + 4
+	ETH_TRAP_PRIO    = ETH_TRAP_REASON + 2
+	ETH_TRAP_FLAGS   = ETH_TRAP_PRIO + 1
+	ETH_TRAP_TSTAMP  = ETH_TRAP_FLAGS + 1
+	ETH_TRAP_P       = ETH_PAYLOAD + SizeofTrapHdr - 2
+	ETH_TRAP_PAYLOAD = ETH_PAYLOAD + SizeofTrapHdr
+)
+
 type EthP uint16
 
 func (p EthP) Network() uint16 { return endian.NetworkUint16(uint16(p)) }
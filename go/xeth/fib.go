@@ -23,6 +23,7 @@ type RtnhFlags uint32
 type FibEntry struct {
 	net.IPNet
 	NHs []*NH
+	NextHopId
 	NetNs
 	RtTable
 	FibEntryEvent
@@ -31,6 +32,20 @@ type FibEntry struct {
 	Ref
 }
 
+// All routes of the NetNs RtTable, or all tables if RtTable is
+// RT_TABLE_UNSPEC, were deleted.
+type FibFlush struct {
+	NetNs
+	RtTable
+}
+
+// All routes with next hops only through this device were deleted.
+type FibFlushDev struct {
+	NetNs
+	Xid
+	Ifindex int32
+}
+
 type NH struct {
 	net.IP
 	Xid
@@ -129,6 +144,7 @@ func fib4(msg *internal.MsgFibEntry) *FibEntry {
 	fe.Rtn = Rtn(msg.Type)
 	fe.RtTable = RtTable(msg.Table)
 	fe.Tos = msg.Tos
+	fe.NextHopId = NextHopId(msg.Nhid)
 	for _, nh := range msg.NextHops() {
 		xid := fe.NetNs.Xid(nh.Ifindex)
 		fenh := newNH()
@@ -154,6 +170,11 @@ func fib6(msg *internal.MsgFib6Entry) *FibEntry {
 	fe.FibEntryEvent = FibEntryEvent(msg.Event)
 	fe.Rtn = Rtn(msg.Type)
 	fe.RtTable = RtTable(msg.Table)
+	fe.NextHopId = NextHopId(msg.Nhid)
+	if fe.NextHopId != 0 {
+		fe.NetNs.fibentry(fe)
+		return fe
+	}
 	nhxid := netns.Xid(msg.Nh.Ifindex)
 	nh := newNH()
 	copy(nh.IP, msg.Nh.Gw[:])
@@ -175,3 +196,118 @@ func fib6(msg *internal.MsgFib6Entry) *FibEntry {
 	fe.NetNs.fibentry(fe)
 	return fe
 }
+
+func fibFlush(msg *internal.MsgFibFlush) FibFlush {
+	flush := FibFlush{
+		NetNs:   NetNs(msg.Net),
+		RtTable: RtTable(msg.Table),
+	}
+	flush.NetNs.fibflush(flush.RtTable)
+	return flush
+}
+
+func fibFlushDev(msg *internal.MsgFibFlushDev) FibFlushDev {
+	flush := FibFlushDev{
+		NetNs:   NetNs(msg.Net),
+		Xid:     Xid(msg.Xid),
+		Ifindex: msg.Ifindex,
+	}
+	flush.NetNs.fibflushdev(flush.Ifindex)
+	return flush
+}
+
+// only via ifindex, either directly or through its nexthop object
+func (fe *FibEntry) onlyVia(ifindex int32) bool {
+	if fe.NextHopId != 0 {
+		switch nh := fe.NetNs.NextHop(fe.NextHopId).(type) {
+		case *NextHop:
+			return nh.Ifindex == ifindex
+		case *NextHopGroup:
+			for _, m := range nh.Members {
+				v, ok := fe.NetNs.NextHop(m.NextHopId).(*NextHop)
+				if !ok || v.Ifindex != ifindex {
+					return false
+				}
+			}
+			return len(nh.Members) > 0
+		}
+		return false
+	}
+	for _, nh := range fe.NHs {
+		if nh.Ifindex != ifindex {
+			return false
+		}
+	}
+	return len(fe.NHs) > 0
+}
+
+func fib4c(buf []byte) interface{} {
+	var c internal.Compact
+	c.Init(buf)
+	fe := newFibEntry()
+	fe.NetNs = NetNs(c.Uvarint())
+	fe.FibEntryEvent = FibEntryEvent(c.Byte())
+	fe.Rtn = Rtn(c.Byte())
+	fe.Tos = c.Byte()
+	length := int(c.Byte())
+	fe.IPNet.IP = fe.IPNet.IP[:net.IPv4len]
+	for i := range fe.IPNet.IP {
+		fe.IPNet.IP[i] = 0
+	}
+	copy(fe.IPNet.IP, c.Bytes((length+7)/8))
+	fe.IPNet.Mask = net.CIDRMask(length, net.IPv4len*8)
+	fe.RtTable = RtTable(c.Uvarint())
+	fe.NextHopId = NextHopId(c.Uvarint())
+	for n := c.Uvarint(); n > 0 && c.Err == nil; n-- {
+		nh := newNH()
+		nh.Ifindex = int32(c.Uvarint())
+		nh.Xid = fe.NetNs.Xid(nh.Ifindex)
+		nh.Weight = int32(c.Uvarint())
+		nh.RtnhFlags = RtnhFlags(c.Uvarint())
+		nh.RtScope = RtScope(c.Byte())
+		nh.IP = nh.IP[:net.IPv4len]
+		copy(nh.IP, c.Bytes(net.IPv4len))
+		fe.NHs = append(fe.NHs, nh)
+	}
+	if c.Err != nil {
+		fe.Pool()
+		return c.Err
+	}
+	fe.NetNs.fibentry(fe)
+	return fe
+}
+
+func fib6c(buf []byte) interface{} {
+	var c internal.Compact
+	c.Init(buf)
+	fe := newFibEntry()
+	fe.NetNs = NetNs(c.Uvarint())
+	fe.FibEntryEvent = FibEntryEvent(c.Byte())
+	fe.Rtn = Rtn(c.Byte())
+	length := int(c.Byte())
+	for i := range fe.IPNet.IP {
+		fe.IPNet.IP[i] = 0
+	}
+	copy(fe.IPNet.IP, c.Bytes((length+7)/8))
+	fe.IPNet.Mask = net.CIDRMask(length, net.IPv6len*8)
+	fe.RtTable = RtTable(c.Uvarint())
+	fe.NextHopId = NextHopId(c.Uvarint())
+	for n := c.Uvarint(); n > 0 && c.Err == nil; n-- {
+		nh := newNH()
+		nh.Ifindex = int32(c.Uvarint())
+		nh.Xid = fe.NetNs.Xid(nh.Ifindex)
+		nh.Weight = int32(c.Uvarint())
+		nh.RtnhFlags = RtnhFlags(c.Uvarint())
+		for i := range nh.IP {
+			nh.IP[i] = 0
+		}
+		copy(nh.IP, c.Bytes(int(c.Byte())))
+		fe.NHs = append(fe.NHs, nh)
+	}
+	if c.Err != nil {
+		fe.Pool()
+		return c.Err
+	}
+	fe.NetNs.fibentry(fe)
+	return fe
+}
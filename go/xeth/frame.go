@@ -29,10 +29,48 @@ func (f Frame) Loopback(task *Task) {
 	task.ExceptionFrame(f.bytes())
 }
 
+// Trap of a frame with the trap encapsulation; Tstamp is ingress nanoseconds
+// or zero if the switch didn't provide it.
+type Trap struct {
+	Xid    Xid
+	Reason uint16
+	Prio   uint8
+	Tstamp uint64
+}
+
+func (f Frame) IsTrap() bool { return isTrap(f.bytes()) }
+
+func isTrap(b []byte) bool {
+	return len(b) >= ETH_TRAP_PAYLOAD &&
+		endian.Network.Uint16(b[ETH_P:]) == EthPTrap
+}
+
+// Trap returns the decoded header of a trapped frame or false if it isn't.
+func (f Frame) Trap() (trap Trap, ok bool) {
+	if ok = f.IsTrap(); !ok {
+		return
+	}
+	b := f.bytes()
+	trap.Xid = Xid(endian.Network.Uint32(b[ETH_TRAP_XID:]))
+	trap.Reason = endian.Network.Uint16(b[ETH_TRAP_REASON:])
+	trap.Prio = b[ETH_TRAP_PRIO]
+	if b[ETH_TRAP_FLAGS]&(1<<TrapFlagTstampBit) != 0 {
+		trap.Tstamp = endian.Network.Uint64(b[ETH_TRAP_TSTAMP:])
+	}
+	return
+}
+
 func (f Frame) Xid(set ...Xid) (xid Xid) {
 	b := f.bytes()
 	p := EthP(endian.Host.Uint16(b[ETH_P:]))
-	if len(set) > 0 {
+	if f.IsTrap() {
+		if len(set) > 0 {
+			xid = set[0]
+			endian.Network.PutUint32(b[ETH_TRAP_XID:], uint32(xid))
+		} else {
+			xid = Xid(endian.Network.Uint32(b[ETH_TRAP_XID:]))
+		}
+	} else if len(set) > 0 {
 		xid = set[0]
 		// FIXME do we need 8021AD?
 		endian.Network.PutUint16(b[ETH_VLAN_TCI:], uint16(xid))
@@ -49,7 +87,9 @@ func (f Frame) Xid(set ...Xid) (xid Xid) {
 func (f Frame) EthP() EthP {
 	b := f.bytes()
 	p := EthP(endian.Host.Uint16(b[ETH_P:]))
-	if p == ETH_P_8021AD {
+	if f.IsTrap() {
+		p = EthP(endian.Host.Uint16(b[ETH_TRAP_P:]))
+	} else if p == ETH_P_8021AD {
 		p = EthP(endian.Host.Uint16(b[ETH_C_VLAN_P:]))
 	} else if p == ETH_P_8021Q {
 		p = EthP(endian.Host.Uint16(b[ETH_VLAN_P:]))
@@ -18,6 +18,28 @@ func VlanTciIsException(tci uint16) bool {
 const (
 	EncapVlan	= 0x0
 	EncapVpls	= 0x1
+	EncapTrap	= 0x2
+)
+
+const EthPTrap = 0x88b5
+
+const (
+	TrapReasonUnspec	= 0x0
+	TrapReasonL2Control	= 0x1
+	TrapReasonArp		= 0x2
+	TrapReasonNd		= 0x3
+	TrapReasonTtl		= 0x4
+	TrapReasonBgp		= 0x5
+	TrapReasonBfd		= 0x6
+	TrapReasonRouteMiss	= 0x7
+	TrapReasonNeighMiss	= 0x8
+	TrapReasonMtu		= 0x9
+	TrapReasonAcl		= 0xa
+)
+
+const (
+	TrapFlagTstampBit	= 0x0
+	SizeofTrapHdr		= 0x14
 )
 
 const (
@@ -35,6 +57,8 @@ const (
 	MuxIflaEncap	= 0x1
 	PortIflaXid	= 0x1
 	VlanIflaVid	= 0x1
+	VlanIflaVidLast	= 0x2
+	VlanIflaNameFmt	= 0x3
 )
 
 const (
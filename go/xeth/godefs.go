@@ -28,6 +28,28 @@ func VlanTciIsException(tci uint16) bool {
 const (
 	EncapVlan = C.XETH_ENCAP_VLAN
 	EncapVpls = C.XETH_ENCAP_VPLS
+	EncapTrap = C.XETH_ENCAP_TRAP
+)
+
+const EthPTrap = C.XETH_ETH_P_TRAP
+
+const (
+	TrapReasonUnspec    = C.XETH_TRAP_REASON_UNSPEC
+	TrapReasonL2Control = C.XETH_TRAP_REASON_L2_CONTROL
+	TrapReasonArp       = C.XETH_TRAP_REASON_ARP
+	TrapReasonNd        = C.XETH_TRAP_REASON_ND
+	TrapReasonTtl       = C.XETH_TRAP_REASON_TTL
+	TrapReasonBgp       = C.XETH_TRAP_REASON_BGP
+	TrapReasonBfd       = C.XETH_TRAP_REASON_BFD
+	TrapReasonRouteMiss = C.XETH_TRAP_REASON_ROUTE_MISS
+	TrapReasonNeighMiss = C.XETH_TRAP_REASON_NEIGH_MISS
+	TrapReasonMtu       = C.XETH_TRAP_REASON_MTU
+	TrapReasonAcl       = C.XETH_TRAP_REASON_ACL
+)
+
+const (
+	TrapFlagTstampBit = C.XETH_TRAP_FLAG_TSTAMP_BIT
+	SizeofTrapHdr     = C.sizeof_struct_xeth_trap_hdr
 )
 
 const (
@@ -41,10 +63,12 @@ const (
 )
 
 const (
-	LbIflaChannel = C.XETH_LB_IFLA_CHANNEL
-	MuxIflaEncap  = C.XETH_MUX_IFLA_ENCAP
-	PortIflaXid   = C.XETH_PORT_IFLA_XID
-	VlanIflaVid   = C.XETH_VLAN_IFLA_VID
+	LbIflaChannel   = C.XETH_LB_IFLA_CHANNEL
+	MuxIflaEncap    = C.XETH_MUX_IFLA_ENCAP
+	PortIflaXid     = C.XETH_PORT_IFLA_XID
+	VlanIflaVid     = C.XETH_VLAN_IFLA_VID
+	VlanIflaVidLast = C.XETH_VLAN_IFLA_VID_LAST
+	VlanIflaNameFmt = C.XETH_VLAN_IFLA_NAME_FMT
 )
 
 const (
@@ -65,8 +65,22 @@ type MsgFibEntry struct {
 	Event	uint8
 	Nhs	uint8
 	Tos	uint8
-	Type	uint8
-	Table	uint32
+	Type		uint8
+	Table		uint32
+	Nhid		uint32
+	Reserved	uint32
+}
+type MsgFibFlush struct {
+	Header		MsgHeader
+	Net		uint64
+	Table		uint32
+	Reserved	uint32
+}
+type MsgFibFlushDev struct {
+	Header	MsgHeader
+	Net	uint64
+	Ifindex	int32
+	Xid	uint32
 }
 type NextHop6 struct {
 	Ifindex		int32
@@ -84,8 +98,19 @@ type MsgFib6Entry struct {
 	Nsiblings	uint8
 	Type		uint8
 	Table		uint32
+	Nhid		uint32
+	Reserved	uint32
 	Nh		NextHop6
 }
+type MsgDumpRequired struct {
+	Header	MsgHeader
+	Dumps	uint8
+	Pad	[7]uint8
+}
+type MsgGen struct {
+	Header	MsgHeader
+	Gen	uint64
+}
 type MsgIfa struct {
 	Header	MsgHeader
 	Xid	uint32
@@ -129,6 +154,41 @@ type MsgNetNs struct {
 	Header	MsgHeader
 	Net	uint64
 }
+type MsgNextHop struct {
+	Header		MsgHeader
+	Net		uint64
+	Id		uint32
+	Event		uint8
+	Family		uint8
+	Flags		uint8
+	Pad		uint8
+	Ifindex		int32
+	Reserved	uint32
+	Gw		[16]uint8
+}
+type NextHopGroupEntry struct {
+	Id	uint32
+	Weight	uint32
+}
+type MsgNextHopGroup struct {
+	Header	MsgHeader
+	Net	uint64
+	Id	uint32
+	Event	uint8
+	Flags	uint8
+	N	uint16
+}
+type MsgQsfp struct {
+	Header	MsgHeader
+	Xid	uint32
+	Event	uint8
+	Pad	[3]uint8
+}
+type MsgSetEncoding struct {
+	Header		MsgHeader
+	Encoding	uint8
+	Pad		[7]uint8
+}
 type MsgSpeed struct {
 	Header	MsgHeader
 	Xid	uint32
@@ -163,6 +223,18 @@ const (
 	MsgKindChangeUpperXid			= 0x12
 	MsgKindNetNsAdd				= 0x13
 	MsgKindNetNsDel				= 0x14
+	MsgKindNextHop				= 0x15
+	MsgKindNextHopGroup			= 0x16
+	MsgKindFibFlush				= 0x17
+	MsgKindFibFlushDev			= 0x18
+	MsgKindSetEncoding			= 0x19
+	MsgKindFibEntryCompact			= 0x1a
+	MsgKindFib6EntryCompact			= 0x1b
+	MsgKindNeighUpdateCompact		= 0x1c
+	MsgKindGen				= 0x1d
+	MsgKindResync				= 0x1e
+	MsgKindDumpRequired			= 0x1f
+	MsgKindQsfp				= 0x20
 )
 
 const (
@@ -172,23 +244,48 @@ const (
 	SizeofMsgChangeUpperXid		= 0x20
 	SizeofMsgDumpFibInfo		= 0x10
 	SizeofMsgDumpIfInfo		= 0x10
+	SizeofMsgDumpRequired		= 0x18
 	SizeofMsgEthtoolFlags		= 0x18
 	SizeofMsgEthtoolSettings	= 0x20
 	SizeofMsgEthtoolLinkModes	= 0x20
+	SizeofMsgGen			= 0x18
 	SizeofMsgIfa			= 0x20
 	SizeofMsgIfa6			= 0x30
 	SizeofMsgIfInfo			= 0x48
 	SizeofNextHop			= 0x18
 	SizeofNextHop6			= 0x20
-	SizeofMsgFibEntry		= 0x28
-	SizeofMsgFib6Entry		= 0x50
+	SizeofMsgFibEntry		= 0x30
+	SizeofMsgFib6Entry		= 0x58
+	SizeofMsgFibFlush		= 0x20
+	SizeofMsgFibFlushDev		= 0x20
 	SizeofMsgNeighUpdate		= 0x38
 	SizeofMsgNetNs			= 0x18
+	SizeofMsgNextHop		= 0x38
+	SizeofNextHopGroupEntry		= 0x8
+	SizeofMsgNextHopGroup		= 0x20
+	SizeofMsgQsfp			= 0x18
+	SizeofMsgSetEncoding		= 0x18
 	SizeofMsgSpeed			= 0x18
 	SizeofMsgStat			= 0x20
 )
 
-const MsgVersion = 0x2
+const MsgVersion = 0x3
+
+const (
+	MsgDumpIfInfoBit	= 0x0
+	MsgDumpFibInfoBit	= 0x1
+)
+
+const (
+	QsfpEventRemoved	= 0x0
+	QsfpEventInserted	= 0x1
+	QsfpEventInterrupt	= 0x2
+)
+
+const (
+	MsgEncodingFixed	= 0x0
+	MsgEncodingCompact	= 0x1
+)
 
 const (
 	SizeofIfName		= 0x10
@@ -239,6 +336,17 @@ const (
 	IfInfoReasonFeatures	= 0x7
 )
 
+const (
+	NextHopEventReplace	= 0x0
+	NextHopEventDel		= 0x1
+)
+
+const (
+	NextHopFlagRejectBit	= 0x0
+	NextHopFlagFdbBit	= 0x1
+	NextHopFlagEncapBit	= 0x2
+)
+
 const (
 	CarrierOff	= 0x0
 	CarrierOn	= 0x1
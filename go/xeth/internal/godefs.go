@@ -20,13 +20,22 @@ type MsgEthtoolSettings C.struct_xeth_msg_ethtool_settings
 type MsgEthtoolLinkModes C.struct_xeth_msg_ethtool_link_modes
 type NextHop C.struct_xeth_next_hop
 type MsgFibEntry C.struct_xeth_msg_fibentry
+type MsgFibFlush C.struct_xeth_msg_fib_flush
+type MsgFibFlushDev C.struct_xeth_msg_fib_flush_dev
 type NextHop6 C.struct_xeth_next_hop6
 type MsgFib6Entry C.struct_xeth_msg_fib6entry
+type MsgDumpRequired C.struct_xeth_msg_dump_required
+type MsgGen C.struct_xeth_msg_gen
 type MsgIfa C.struct_xeth_msg_ifa
 type MsgIfa6 C.struct_xeth_msg_ifa6
 type MsgIfInfo C.struct_xeth_msg_ifinfo
 type MsgNeighUpdate C.struct_xeth_msg_neigh_update
 type MsgNetNs C.struct_xeth_msg_netns
+type MsgNextHop C.struct_xeth_msg_nexthop
+type NextHopGroupEntry C.struct_xeth_nexthop_group_entry
+type MsgNextHopGroup C.struct_xeth_msg_nexthop_group
+type MsgQsfp C.struct_xeth_msg_qsfp
+type MsgSetEncoding C.struct_xeth_msg_set_encoding
 type MsgSpeed C.struct_xeth_msg_speed
 type MsgStat C.struct_xeth_msg_stat
 
@@ -52,6 +61,18 @@ const (
 	MsgKindChangeUpperXid                = C.XETH_MSG_KIND_CHANGE_UPPER_XID
 	MsgKindNetNsAdd                      = C.XETH_MSG_KIND_NETNS_ADD
 	MsgKindNetNsDel                      = C.XETH_MSG_KIND_NETNS_DEL
+	MsgKindNextHop                       = C.XETH_MSG_KIND_NEXTHOP
+	MsgKindNextHopGroup                  = C.XETH_MSG_KIND_NEXTHOP_GROUP
+	MsgKindFibFlush                      = C.XETH_MSG_KIND_FIB_FLUSH
+	MsgKindFibFlushDev                   = C.XETH_MSG_KIND_FIB_FLUSH_DEV
+	MsgKindSetEncoding                   = C.XETH_MSG_KIND_SET_ENCODING
+	MsgKindFibEntryCompact               = C.XETH_MSG_KIND_FIBENTRY_COMPACT
+	MsgKindFib6EntryCompact              = C.XETH_MSG_KIND_FIB6ENTRY_COMPACT
+	MsgKindNeighUpdateCompact            = C.XETH_MSG_KIND_NEIGH_UPDATE_COMPACT
+	MsgKindGen                           = C.XETH_MSG_KIND_GEN
+	MsgKindResync                        = C.XETH_MSG_KIND_RESYNC
+	MsgKindDumpRequired                  = C.XETH_MSG_KIND_DUMP_REQUIRED
+	MsgKindQsfp                          = C.XETH_MSG_KIND_QSFP
 )
 
 const (
@@ -61,9 +82,11 @@ const (
 	SizeofMsgChangeUpperXid   = C.sizeof_struct_xeth_msg_change_upper_xid
 	SizeofMsgDumpFibInfo      = C.sizeof_struct_xeth_msg_dump_fibinfo
 	SizeofMsgDumpIfInfo       = C.sizeof_struct_xeth_msg_dump_ifinfo
+	SizeofMsgDumpRequired     = C.sizeof_struct_xeth_msg_dump_required
 	SizeofMsgEthtoolFlags     = C.sizeof_struct_xeth_msg_ethtool_flags
 	SizeofMsgEthtoolSettings  = C.sizeof_struct_xeth_msg_ethtool_settings
 	SizeofMsgEthtoolLinkModes = C.sizeof_struct_xeth_msg_ethtool_link_modes
+	SizeofMsgGen              = C.sizeof_struct_xeth_msg_gen
 	SizeofMsgIfa              = C.sizeof_struct_xeth_msg_ifa
 	SizeofMsgIfa6             = C.sizeof_struct_xeth_msg_ifa6
 	SizeofMsgIfInfo           = C.sizeof_struct_xeth_msg_ifinfo
@@ -71,14 +94,37 @@ const (
 	SizeofNextHop6            = C.sizeof_struct_xeth_next_hop6
 	SizeofMsgFibEntry         = C.sizeof_struct_xeth_msg_fibentry
 	SizeofMsgFib6Entry        = C.sizeof_struct_xeth_msg_fib6entry
+	SizeofMsgFibFlush         = C.sizeof_struct_xeth_msg_fib_flush
+	SizeofMsgFibFlushDev      = C.sizeof_struct_xeth_msg_fib_flush_dev
 	SizeofMsgNeighUpdate      = C.sizeof_struct_xeth_msg_neigh_update
 	SizeofMsgNetNs            = C.sizeof_struct_xeth_msg_netns
+	SizeofMsgNextHop          = C.sizeof_struct_xeth_msg_nexthop
+	SizeofNextHopGroupEntry   = C.sizeof_struct_xeth_nexthop_group_entry
+	SizeofMsgNextHopGroup     = C.sizeof_struct_xeth_msg_nexthop_group
+	SizeofMsgQsfp             = C.sizeof_struct_xeth_msg_qsfp
+	SizeofMsgSetEncoding      = C.sizeof_struct_xeth_msg_set_encoding
 	SizeofMsgSpeed            = C.sizeof_struct_xeth_msg_speed
 	SizeofMsgStat             = C.sizeof_struct_xeth_msg_stat
 )
 
 const MsgVersion = C.XETH_MSG_VERSION
 
+const (
+	MsgDumpIfInfoBit  = C.XETH_MSG_DUMP_IFINFO_BIT
+	MsgDumpFibInfoBit = C.XETH_MSG_DUMP_FIBINFO_BIT
+)
+
+const (
+	QsfpEventRemoved   = C.XETH_QSFP_EVENT_REMOVED
+	QsfpEventInserted  = C.XETH_QSFP_EVENT_INSERTED
+	QsfpEventInterrupt = C.XETH_QSFP_EVENT_INTERRUPT
+)
+
+const (
+	MsgEncodingFixed   = C.XETH_MSG_ENCODING_FIXED
+	MsgEncodingCompact = C.XETH_MSG_ENCODING_COMPACT
+)
+
 const (
 	SizeofIfName     = C.XETH_IFNAMSIZ
 	SizeofEthAddr    = C.XETH_ALEN
@@ -128,6 +174,17 @@ const (
 	IfInfoReasonFeatures = C.XETH_IFINFO_REASON_FEATURES
 )
 
+const (
+	NextHopEventReplace = C.XETH_NEXTHOP_EVENT_REPLACE
+	NextHopEventDel     = C.XETH_NEXTHOP_EVENT_DEL
+)
+
+const (
+	NextHopFlagRejectBit = C.XETH_NEXTHOP_FLAG_REJECT_BIT
+	NextHopFlagFdbBit    = C.XETH_NEXTHOP_FLAG_FDB_BIT
+	NextHopFlagEncapBit  = C.XETH_NEXTHOP_FLAG_ENCAP_BIT
+)
+
 const (
 	CarrierOff = C.XETH_CARRIER_OFF
 	CarrierOn  = C.XETH_CARRIER_ON
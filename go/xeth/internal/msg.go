@@ -5,6 +5,8 @@
 package internal
 
 import (
+	"encoding/binary"
+	"errors"
 	"fmt"
 	"reflect"
 	"unsafe"
@@ -33,10 +35,16 @@ func (h *MsgHeader) Validate(buf []byte) error {
 	}
 	var exact, min int
 	switch h.Kind {
+	case MsgKindFibEntryCompact,
+		MsgKindFib6EntryCompact,
+		MsgKindNeighUpdateCompact:
+		min = SizeofMsg
 	case MsgKindFibEntry:
 		min = SizeofMsgFibEntry
 	case MsgKindFib6Entry:
 		min = SizeofMsgFib6Entry
+	case MsgKindNextHopGroup:
+		min = SizeofMsgNextHopGroup
 	case MsgKindEthtoolLinkModesSupported,
 		MsgKindEthtoolLinkModesAdvertising,
 		MsgKindEthtoolLinkModesLPAdvertising:
@@ -61,6 +69,18 @@ func (h *MsgHeader) Validate(buf []byte) error {
 		exact = SizeofMsgNetNs
 	case MsgKindNetNsDel:
 		exact = SizeofMsgNetNs
+	case MsgKindNextHop:
+		exact = SizeofMsgNextHop
+	case MsgKindFibFlush:
+		exact = SizeofMsgFibFlush
+	case MsgKindFibFlushDev:
+		exact = SizeofMsgFibFlushDev
+	case MsgKindGen, MsgKindResync:
+		exact = SizeofMsgGen
+	case MsgKindDumpRequired:
+		exact = SizeofMsgDumpRequired
+	case MsgKindQsfp:
+		exact = SizeofMsgQsfp
 	default:
 		return fmt.Errorf("msg kind %d unsupported", h.Kind)
 	}
@@ -95,3 +115,71 @@ func (msg *MsgFib6Entry) Siblings() []NextHop6 {
 		Cap:  nsiblings,
 	}))
 }
+
+func (msg *MsgNextHopGroup) Entries() []NextHopGroupEntry {
+	n := int(msg.N)
+	if n == 0 {
+		return []NextHopGroupEntry{}
+	}
+	ptr := unsafe.Pointer(msg)
+	entries := make([]NextHopGroupEntry, n)
+	for i := range entries {
+		entries[i] = *(*NextHopGroupEntry)(unsafe.Pointer(uintptr(ptr) +
+			SizeofMsgNextHopGroup + uintptr(i)*SizeofNextHopGroupEntry))
+	}
+	return entries
+}
+
+var ErrCompact = errors.New("truncated compact msg")
+
+// Compact decodes the fields that follow the header of a compact message.
+type Compact struct {
+	b   []byte
+	Err error
+}
+
+func (c *Compact) Init(buf []byte) {
+	c.b = buf[SizeofMsg:]
+	c.Err = nil
+}
+
+func (c *Compact) Uvarint() uint64 {
+	if c.Err != nil {
+		return 0
+	}
+	v, n := binary.Uvarint(c.b)
+	if n <= 0 {
+		c.Err = ErrCompact
+		return 0
+	}
+	c.b = c.b[n:]
+	return v
+}
+
+func (c *Compact) Byte() uint8 {
+	if c.Err != nil {
+		return 0
+	}
+	if len(c.b) < 1 {
+		c.Err = ErrCompact
+		return 0
+	}
+	v := c.b[0]
+	c.b = c.b[1:]
+	return v
+}
+
+// Bytes returns the next n bytes, which are only valid until the message
+// buffer is pooled.
+func (c *Compact) Bytes(n int) []byte {
+	if c.Err != nil {
+		return nil
+	}
+	if len(c.b) < n {
+		c.Err = ErrCompact
+		return nil
+	}
+	v := c.b[:n]
+	c.b = c.b[n:]
+	return v
+}
@@ -68,3 +68,30 @@ func neighbor(msg *internal.MsgNeighUpdate) *Neighbor {
 	netns.neighbor(neigh)
 	return neigh
 }
+
+func neighborc(buf []byte) interface{} {
+	var c internal.Compact
+	c.Init(buf)
+	neigh := newNeighbor()
+	netns := NetNs(c.Uvarint())
+	neigh.NetNs = netns
+	neigh.Xid = netns.Xid(int32(c.Uvarint()))
+	family := c.Byte()
+	dst := c.Bytes(int(c.Byte()))
+	copy(neigh.IP, dst)
+	if family == syscall.AF_INET {
+		neigh.IP = neigh.IP[:net.IPv4len]
+	} else {
+		neigh.IP = neigh.IP[:net.IPv6len]
+	}
+	for i := range neigh.HardwareAddr {
+		neigh.HardwareAddr[i] = 0
+	}
+	copy(neigh.HardwareAddr, c.Bytes(int(c.Byte())))
+	if c.Err != nil {
+		neigh.Pool()
+		return c.Err
+	}
+	netns.neighbor(neigh)
+	return neigh
+}
@@ -32,6 +32,7 @@ type netnsAttrs struct {
 	path     string // or pid
 	xids     sync.Map
 	neigbors sync.Map
+	nexthops sync.Map
 	localRT  sync.Map
 	mainRT   sync.Map
 	otherRTs sync.Map
@@ -144,6 +145,18 @@ func (ns NetNs) Neighbors(f func(neigh *Neighbor) bool) {
 	})
 }
 
+// NextHop returns the cached *NextHop or *NextHopGroup with the given id.
+func (ns NetNs) NextHop(id NextHopId) (v interface{}) {
+	v, _ = ns.attrs().nexthops.Load(id)
+	return
+}
+
+func (ns NetNs) NextHops(f func(v interface{}) bool) {
+	ns.attrs().nexthops.Range(func(k, v interface{}) bool {
+		return f(v)
+	})
+}
+
 func (ns NetNs) Path() string {
 	attrs := ns.attrs()
 	if len(attrs.path) > 0 {
@@ -291,6 +304,44 @@ func (ns NetNs) fibentry(fe *FibEntry) {
 	}
 }
 
+func (ns NetNs) fibflush(rt RtTable) {
+	flush := func(rtm *sync.Map) {
+		rtm.Range(func(k, v interface{}) bool {
+			rtm.Delete(k)
+			v.(*FibEntry).Pool()
+			return true
+		})
+	}
+	attrs := ns.attrs()
+	if rt != RT_TABLE_UNSPEC {
+		flush(ns.rtm(rt))
+		return
+	}
+	flush(&attrs.mainRT)
+	flush(&attrs.localRT)
+	attrs.otherRTs.Range(func(k, v interface{}) bool {
+		flush(v.(*sync.Map))
+		return true
+	})
+	attrs.nexthops.Range(func(k, v interface{}) bool {
+		attrs.nexthops.Delete(k)
+		return true
+	})
+}
+
+func (ns NetNs) fibflushdev(ifindex int32) {
+	for _, rt := range ns.RtTables() {
+		rtm := ns.rtm(rt)
+		rtm.Range(func(k, v interface{}) bool {
+			if fe := v.(*FibEntry); fe.onlyVia(ifindex) {
+				rtm.Delete(k)
+				fe.Pool()
+			}
+			return true
+		})
+	}
+}
+
 func (ns NetNs) neighbor(neigh *Neighbor) {
 	attrs := ns.attrs()
 	sip := neigh.IP.String()
@@ -310,6 +361,15 @@ func (ns NetNs) neighbor(neigh *Neighbor) {
 	attrs.neigbors.Store(sip, neigh)
 }
 
+func (ns NetNs) nexthop(id NextHopId, event NextHopEvent, v interface{}) {
+	attrs := ns.attrs()
+	if event == NextHopEventDel {
+		attrs.nexthops.Delete(id)
+	} else {
+		attrs.nexthops.Store(id, v)
+	}
+}
+
 func (ns NetNs) rtm(rt RtTable) (rtm *sync.Map) {
 	attrs := ns.attrs()
 	switch rt {
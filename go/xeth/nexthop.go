@@ -0,0 +1,93 @@
+// Copyright © 2018-2020 Platina Systems, Inc. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+package xeth
+
+import (
+	"net"
+	"syscall"
+
+	"github.com/platinasystems/xeth/v3/go/xeth/internal"
+)
+
+// Kernel nexthop object id; a FibEntry with a non-zero NextHopId refers to
+// the NextHop or NextHopGroup of its NetNs rather than listing its NHs.
+type NextHopId uint32
+
+type NextHopEvent uint8
+type NextHopFlags uint8
+
+const (
+	NextHopEventReplace = NextHopEvent(internal.NextHopEventReplace)
+	NextHopEventDel     = NextHopEvent(internal.NextHopEventDel)
+)
+
+const (
+	NextHopFlagReject = NextHopFlags(1 << internal.NextHopFlagRejectBit)
+	NextHopFlagFdb    = NextHopFlags(1 << internal.NextHopFlagFdbBit)
+	NextHopFlagEncap  = NextHopFlags(1 << internal.NextHopFlagEncapBit)
+)
+
+type NextHop struct {
+	NetNs
+	NextHopId
+	NextHopEvent
+	NextHopFlags
+	net.IP
+	Xid
+	Ifindex int32
+}
+
+type NextHopGroup struct {
+	NetNs
+	NextHopId
+	NextHopEvent
+	NextHopFlags
+	Members []NextHopGroupMember
+}
+
+type NextHopGroupMember struct {
+	NextHopId
+	Weight uint32
+}
+
+func nexthop(msg *internal.MsgNextHop) *NextHop {
+	netns := NetNs(msg.Net)
+	nh := &NextHop{
+		NetNs:        netns,
+		NextHopId:    NextHopId(msg.Id),
+		NextHopEvent: NextHopEvent(msg.Event),
+		NextHopFlags: NextHopFlags(msg.Flags),
+		Xid:          netns.Xid(msg.Ifindex),
+		Ifindex:      msg.Ifindex,
+	}
+	switch msg.Family {
+	case syscall.AF_INET:
+		nh.IP = make(net.IP, net.IPv4len)
+		copy(nh.IP, msg.Gw[:net.IPv4len])
+	case syscall.AF_INET6:
+		nh.IP = make(net.IP, net.IPv6len)
+		copy(nh.IP, msg.Gw[:])
+	}
+	netns.nexthop(nh.NextHopId, nh.NextHopEvent, nh)
+	return nh
+}
+
+func nexthopGroup(msg *internal.MsgNextHopGroup) *NextHopGroup {
+	netns := NetNs(msg.Net)
+	entries := msg.Entries()
+	nhg := &NextHopGroup{
+		NetNs:        netns,
+		NextHopId:    NextHopId(msg.Id),
+		NextHopEvent: NextHopEvent(msg.Event),
+		NextHopFlags: NextHopFlags(msg.Flags),
+		Members:      make([]NextHopGroupMember, len(entries)),
+	}
+	for i, entry := range entries {
+		nhg.Members[i].NextHopId = NextHopId(entry.Id)
+		nhg.Members[i].Weight = entry.Weight
+	}
+	netns.nexthop(nhg.NextHopId, nhg.NextHopEvent, nhg)
+	return nhg
+}
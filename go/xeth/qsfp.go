@@ -0,0 +1,22 @@
+// Copyright © 2018-2020 Platina Systems, Inc. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+package xeth
+
+import "github.com/platinasystems/xeth/v3/go/xeth/internal"
+
+type QsfpEvent uint8
+
+const (
+	QsfpRemoved   QsfpEvent = internal.QsfpEventRemoved
+	QsfpInserted  QsfpEvent = internal.QsfpEventInserted
+	QsfpInterrupt QsfpEvent = internal.QsfpEventInterrupt
+)
+
+// DevQsfp is the module insertion, removal, or interrupt of a port; the
+// driver also sends inserted or removed with each port's ifinfo dump.
+type DevQsfp struct {
+	Xid
+	QsfpEvent
+}
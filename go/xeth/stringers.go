@@ -18,6 +18,22 @@ func (xid Xid) Format(w fmt.State, c rune) {
 
 func (Break) String() string { return "break" }
 
+func (gen Gen) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, "gen ", uint64(gen))
+}
+
+func (ResyncFull) String() string { return "resync full" }
+
+func (msg DumpRequired) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, "dump required")
+	if msg.IfInfo {
+		fmt.Fprint(w, " ifinfo")
+	}
+	if msg.FibInfo {
+		fmt.Fprint(w, " fibinfo")
+	}
+}
+
 func (dev DevNew) Format(w fmt.State, c rune) {
 	xid := Xid(dev)
 	fmt.Fprint(w, "new ", xid)
@@ -83,6 +99,22 @@ func (dev *DevEthtoolFlags) Format(w fmt.State, c rune) {
 	fmt.Fprint(w, dev.Xid, " ethtool flags <", dev.EthtoolFlagBits, ">")
 }
 
+func (dev DevQsfp) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, dev.Xid, " qsfp ", dev.QsfpEvent)
+}
+
+func (event QsfpEvent) String() string {
+	switch event {
+	case QsfpRemoved:
+		return "removed"
+	case QsfpInserted:
+		return "inserted"
+	case QsfpInterrupt:
+		return "interrupt"
+	}
+	return "unknown"
+}
+
 func (dev DevEthtoolSettings) Format(w fmt.State, c rune) {
 	xid := Xid(dev)
 	fmt.Fprint(w, xid)
@@ -206,7 +238,9 @@ func (msg *FibEntry) Format(w fmt.State, c rune) {
 	fmt.Fprint(w, " table ", msg.RtTable)
 	fmt.Fprint(w, " type ", msg.Rtn)
 	fmt.Fprint(w, " ", &msg.IPNet)
-	if len(msg.NHs) == 1 {
+	if msg.NextHopId != 0 {
+		fmt.Fprint(w, " nhid ", msg.NextHopId)
+	} else if len(msg.NHs) == 1 {
 		fmt.Fprint(w, " nexthop ", msg.NHs[0])
 	} else {
 		fmt.Fprint(w, " nexthops [")
@@ -219,6 +253,17 @@ func (msg *FibEntry) Format(w fmt.State, c rune) {
 	}
 }
 
+func (msg FibFlush) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, "flush netns ", msg.NetNs)
+	if msg.RtTable != RT_TABLE_UNSPEC {
+		fmt.Fprint(w, " table ", msg.RtTable)
+	}
+}
+
+func (msg FibFlushDev) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, "flush netns ", msg.NetNs, " dev ", msg.Xid)
+}
+
 func (msg *Neighbor) Format(w fmt.State, c rune) {
 	fmt.Fprint(w, "neighbor")
 	fmt.Fprint(w, " netns ", msg.NetNs)
@@ -245,6 +290,63 @@ func (nh *NH) Format(w fmt.State, c rune) {
 	fmt.Fprint(w, "}")
 }
 
+func (msg *NextHop) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, "nexthop ", msg.NextHopEvent)
+	fmt.Fprint(w, " netns ", msg.NetNs)
+	fmt.Fprint(w, " id ", uint32(msg.NextHopId))
+	if len(msg.IP) > 0 {
+		fmt.Fprint(w, " via ", msg.IP)
+	}
+	if msg.Ifindex != 0 {
+		fmt.Fprint(w, " dev ", msg.Xid)
+	}
+	fmt.Fprint(w, " flags <", msg.NextHopFlags, ">")
+}
+
+func (msg *NextHopGroup) Format(w fmt.State, c rune) {
+	fmt.Fprint(w, "nexthop-group ", msg.NextHopEvent)
+	fmt.Fprint(w, " netns ", msg.NetNs)
+	fmt.Fprint(w, " id ", uint32(msg.NextHopId))
+	fmt.Fprint(w, " [")
+	sep := ""
+	for _, m := range msg.Members {
+		fmt.Fprint(w, sep, uint32(m.NextHopId), "/", m.Weight)
+		sep = ", "
+	}
+	fmt.Fprint(w, "]")
+}
+
+func (event NextHopEvent) String() string {
+	s, found := map[NextHopEvent]string{
+		NextHopEventReplace: "replace",
+		NextHopEventDel:     "del",
+	}[event]
+	if !found {
+		s = fmt.Sprint("unknown-", uint8(event))
+	}
+	return s
+}
+
+func (flags NextHopFlags) Format(w fmt.State, c rune) {
+	sep := ""
+	for _, x := range []struct {
+		flag NextHopFlags
+		name string
+	}{
+		{NextHopFlagReject, "reject"},
+		{NextHopFlagFdb, "fdb"},
+		{NextHopFlagEncap, "encap"},
+	} {
+		if flags&x.flag == x.flag {
+			fmt.Fprint(w, sep, x.name)
+			sep = ", "
+		}
+	}
+	if len(sep) == 0 {
+		fmt.Fprint(w, "none")
+	}
+}
+
 func (event FibEntryEvent) String() string {
 	s, found := map[FibEntryEvent]string{
 		FIB_EVENT_ENTRY_REPLACE: "replace",
@@ -8,7 +8,6 @@ package xeth
 
 import (
 	"errors"
-	"fmt"
 	"io"
 	"io/ioutil"
 	"net"
@@ -30,6 +29,20 @@ const unixpacket = "unixpacket"
 
 type Break struct{}
 
+// Gen is the generation of the last driver message sent; it's marked after
+// the driver empties its queue once synced by DumpFib or Resync.
+type Gen uint64
+
+// ResyncFull is the driver's reply to a Resync that it can no longer satisfy
+// from its journal; the task should DumpIfInfo and DumpFib instead.
+type ResyncFull struct{}
+
+// DumpRequired indicates that the driver has dropped updates after
+// overflowing its queue; the task should request the respective dumps.
+type DumpRequired struct {
+	IfInfo, FibInfo bool
+}
+
 var (
 	Cloned  Counter // cloned received messages
 	Parsed  Counter // messages parsed by user
@@ -55,12 +68,12 @@ type Task struct {
 	muxsa syscall.SockaddrLinklayer
 }
 
-// Write provision value to platform device sysfs file
+// Write the number of subports (1, 2, or 4) to the provision attribute of an
+// xeth-port platform device, e.g. "xeth-port.3". The driver replaces that
+// port's netdevs with the new set, sending IFINFO DEL and NEW for each.
 func Provision(dev, val string) error {
 	if len(val) == 0 {
-		// have to write something to get sysfs store handler to run
-		// which will then open the atsock
-		val = " "
+		return nil
 	}
 	sysfsdir := filepath.Join("/sys/bus/platform/devices", dev)
 	_, err := os.Stat(sysfsdir)
@@ -72,12 +85,7 @@ func Provision(dev, val string) error {
 		return err
 	}
 	provision := filepath.Join(sysfsdir, "provision")
-	err = ioutil.WriteFile(provision, []byte(val), 0644)
-	if errors.Is(err, syscall.EBUSY) {
-		fmt.Fprintln(os.Stderr, "ignoring provision until xeth reload")
-		err = nil
-	}
-	return err
+	return ioutil.WriteFile(provision, []byte(val), 0644)
 }
 
 // Connect socket and run channel service routines.
@@ -166,6 +174,20 @@ func Parse(buf Buffer) interface{} {
 	switch k := kind(buf); k {
 	case internal.MsgKindBreak:
 		return Break{}
+	case internal.MsgKindGen:
+		msg := (*internal.MsgGen)(buf.pointer())
+		return Gen(msg.Gen)
+	case internal.MsgKindResync:
+		return ResyncFull{}
+	case internal.MsgKindDumpRequired:
+		msg := (*internal.MsgDumpRequired)(buf.pointer())
+		return DumpRequired{
+			IfInfo:  msg.Dumps&(1<<internal.MsgDumpIfInfoBit) != 0,
+			FibInfo: msg.Dumps&(1<<internal.MsgDumpFibInfoBit) != 0,
+		}
+	case internal.MsgKindQsfp:
+		msg := (*internal.MsgQsfp)(buf.pointer())
+		return DevQsfp{Xid(msg.Xid), QsfpEvent(msg.Event)}
 	case internal.MsgKindChangeUpperXid:
 		msg := (*internal.MsgChangeUpperXid)(buf.pointer())
 		lower := Xid(msg.Lower)
@@ -196,6 +218,16 @@ func Parse(buf Buffer) interface{} {
 	case internal.MsgKindFib6Entry:
 		msg := (*internal.MsgFib6Entry)(buf.pointer())
 		return fib6(msg)
+	case internal.MsgKindFibEntryCompact:
+		return fib4c(buf.bytes())
+	case internal.MsgKindFib6EntryCompact:
+		return fib6c(buf.bytes())
+	case internal.MsgKindFibFlush:
+		msg := (*internal.MsgFibFlush)(buf.pointer())
+		return fibFlush(msg)
+	case internal.MsgKindFibFlushDev:
+		msg := (*internal.MsgFibFlushDev)(buf.pointer())
+		return fibFlushDev(msg)
 	case internal.MsgKindIfa:
 		msg := (*internal.MsgIfa)(buf.pointer())
 		xid := Xid(msg.Xid)
@@ -238,12 +270,20 @@ func Parse(buf Buffer) interface{} {
 	case internal.MsgKindNeighUpdate:
 		msg := (*internal.MsgNeighUpdate)(buf.pointer())
 		return neighbor(msg)
+	case internal.MsgKindNeighUpdateCompact:
+		return neighborc(buf.bytes())
 	case internal.MsgKindNetNsAdd:
 		msg := (*internal.MsgNetNs)(buf.pointer())
 		return NetNsAdd{NetNs(msg.Net)}
 	case internal.MsgKindNetNsDel:
 		msg := (*internal.MsgNetNs)(buf.pointer())
 		return NetNsDel{NetNs(msg.Net)}
+	case internal.MsgKindNextHop:
+		msg := (*internal.MsgNextHop)(buf.pointer())
+		return nexthop(msg)
+	case internal.MsgKindNextHopGroup:
+		msg := (*internal.MsgNextHopGroup)(buf.pointer())
+		return nexthopGroup(msg)
 	}
 	return nil
 }
@@ -273,11 +313,45 @@ func (task *Task) DumpIfInfo() {
 	task.hich <- buf
 }
 
+// Request the messages after the given generation, which the driver replays
+// from its journal followed by a Break; or, replies ResyncFull if it no
+// longer has all of them.
+func (task *Task) Resync(gen Gen) {
+	buf := newBuffer(internal.SizeofMsgGen)
+	msg := (*internal.MsgGen)(buf.pointer())
+	msg.Header.Set(internal.MsgKindResync)
+	msg.Gen = uint64(gen)
+	task.hich <- buf
+}
+
+// Confirm that the task has sent the carrier of every port after a reconnect
+// so that the driver drops the carrier it kept for the others.
+func (task *Task) Break() {
+	buf := newBuffer(internal.SizeofMsgBreak)
+	msg := (*internal.MsgHeader)(buf.pointer())
+	msg.Set(internal.MsgKindBreak)
+	task.hich <- buf
+}
+
+// Request compact FIB and neighbor messages; to apply to the FIB dump,
+// call this before DumpFib. The driver reverts to fixed messages when the
+// task disconnects.
+func (task *Task) CompactEncoding() {
+	buf := newBuffer(internal.SizeofMsgSetEncoding)
+	msg := (*internal.MsgSetEncoding)(buf.pointer())
+	msg.Header.Set(internal.MsgKindSetEncoding)
+	msg.Encoding = internal.MsgEncodingCompact
+	task.hich <- buf
+}
+
 // Send an exception frame to driver through raw socket.
 func (task *Task) ExceptionFrame(b []byte) {
 	// set priority so that the xeth will forward to the
-	// respective upper device rather than it's port
-	b[ETH_VLAN_TCI] |= VlanPrioMask >> 8
+	// respective upper device rather than it's port;
+	// a trapped frame is already distinguished by its ethertype
+	if !isTrap(b) {
+		b[ETH_VLAN_TCI] |= VlanPrioMask >> 8
+	}
 	syscall.Sendto(task.muxfd, b, 0, &task.muxsa)
 }
 
@@ -0,0 +1,339 @@
+// Copyright © 2021 Platina Systems, Inc. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+package xeth
+
+import (
+	"errors"
+	"net"
+	"sync/atomic"
+	"syscall"
+	"unsafe"
+)
+
+// linux/if_xdp.h
+const (
+	afXdp  = 44
+	solXdp = 283
+
+	xdpMmapOffsets        = 1
+	xdpRxRing             = 2
+	xdpTxRing             = 3
+	xdpUmemReg            = 4
+	xdpUmemFillRing       = 5
+	xdpUmemCompletionRing = 6
+
+	xdpCopy = 1 << 1
+
+	xdpPgoffRxRing             = 0
+	xdpPgoffTxRing             = 0x80000000
+	xdpUmemPgoffFillRing       = 0x100000000
+	xdpUmemPgoffCompletionRing = 0x180000000
+)
+
+// linux/bpf.h
+const (
+	bpfMapUpdateElem = 2
+	bpfObjGet        = 7
+)
+
+// UMEM chunks are XskFrameSize so an Xsk can't receive jumbo frames; these go
+// to the raw socket instead. Each ring has XskRingSize entries.
+const (
+	XskFrameSize = 4096
+	XskRingSize  = 2048
+	xskFrames    = 2 * XskRingSize
+)
+
+var ErrXskFull = errors.New("xsk tx ring full")
+
+type xdpRingOffset struct{ Producer, Consumer, Desc, Flags uint64 }
+
+type xdpMmapOffsetsT struct{ Rx, Tx, Fr, Cr xdpRingOffset }
+
+type xdpUmemRegT struct {
+	Addr, Len           uint64
+	ChunkSize, Headroom uint32
+}
+
+type sockaddrXdp struct {
+	Family, Flags                  uint16
+	Ifindex, QueueId, SharedUmemFd uint32
+}
+
+type xdpDesc struct {
+	Addr         uint64
+	Len, Options uint32
+}
+
+type xskRing struct {
+	mem        []byte
+	prod, cons *uint32
+	desc       unsafe.Pointer
+}
+
+// Xsk is an AF_XDP socket on a receive queue of the mux. The mux receives
+// each switch-less or unlinked-switch proxy transmit frame on queue
+// (vid % queues) of the outer tag, and if an XDP program redirects it to
+// this socket's XSKMAP entry, Rx has it without a syscall or copy per frame.
+// Tx frames are exceptions, as with Task.ExceptionFrame.
+//
+// The mux is a virtual device, so the socket binds in copy mode.
+type Xsk struct {
+	fd             int
+	umem           []byte
+	rx, tx, fr, cr xskRing
+	free           []uint64 // UMEM frames for tx; rx has the rest
+}
+
+// OpenXsk binds an AF_XDP socket to the given mux receive queue. If xskmap
+// is the path of a pinned BPF_MAP_TYPE_XSKMAP, it also stores the socket
+// at the queue index of that map, as expected by a program like:
+//
+//	return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+func OpenXsk(mux string, queue int, xskmap string) (*Xsk, error) {
+	muxif, err := net.InterfaceByName(mux)
+	if err != nil {
+		return nil, err
+	}
+	fd, err := syscall.Socket(afXdp, syscall.SOCK_RAW, 0)
+	if err != nil {
+		return nil, err
+	}
+	x := &Xsk{fd: fd}
+	if err = x.init(muxif.Index, queue); err == nil && len(xskmap) > 0 {
+		err = xskmapUpdate(xskmap, uint32(queue), uint32(fd))
+	}
+	if err != nil {
+		x.Close()
+		return nil, err
+	}
+	return x, nil
+}
+
+func (x *Xsk) init(ifindex, queue int) (err error) {
+	x.umem, err = syscall.Mmap(-1, 0, xskFrames*XskFrameSize,
+		syscall.PROT_READ|syscall.PROT_WRITE,
+		syscall.MAP_PRIVATE|syscall.MAP_ANONYMOUS)
+	if err != nil {
+		return
+	}
+	reg := xdpUmemRegT{
+		Addr:      uint64(uintptr(unsafe.Pointer(&x.umem[0]))),
+		Len:       uint64(len(x.umem)),
+		ChunkSize: XskFrameSize,
+	}
+	if err = x.setsockopt(xdpUmemReg, unsafe.Pointer(&reg),
+		unsafe.Sizeof(reg)); err != nil {
+		return
+	}
+	for _, opt := range []uintptr{
+		xdpUmemFillRing,
+		xdpUmemCompletionRing,
+		xdpRxRing,
+		xdpTxRing,
+	} {
+		n := uint32(XskRingSize)
+		if err = x.setsockopt(opt, unsafe.Pointer(&n),
+			unsafe.Sizeof(n)); err != nil {
+			return
+		}
+	}
+	var off xdpMmapOffsetsT
+	offlen := uint32(unsafe.Sizeof(off))
+	_, _, errno := syscall.Syscall6(syscall.SYS_GETSOCKOPT,
+		uintptr(x.fd), solXdp, xdpMmapOffsets,
+		uintptr(unsafe.Pointer(&off)),
+		uintptr(unsafe.Pointer(&offlen)), 0)
+	if errno != 0 {
+		return errno
+	}
+	const (
+		sizeofAddr = 8
+		sizeofDesc = int(unsafe.Sizeof(xdpDesc{}))
+	)
+	for _, r := range []struct {
+		ring  *xskRing
+		off   *xdpRingOffset
+		pgoff int64
+		size  int
+	}{
+		{&x.fr, &off.Fr, xdpUmemPgoffFillRing, sizeofAddr},
+		{&x.cr, &off.Cr, xdpUmemPgoffCompletionRing, sizeofAddr},
+		{&x.rx, &off.Rx, xdpPgoffRxRing, sizeofDesc},
+		{&x.tx, &off.Tx, xdpPgoffTxRing, sizeofDesc},
+	} {
+		if err = r.ring.mmap(x.fd, r.off, r.pgoff, r.size); err != nil {
+			return
+		}
+	}
+	// give the first half of UMEM to rx, keep the rest for tx
+	for i := 0; i < XskRingSize; i++ {
+		*x.fr.addr(uint32(i)) = uint64(i * XskFrameSize)
+	}
+	atomic.StoreUint32(x.fr.prod, XskRingSize)
+	for i := XskRingSize; i < xskFrames; i++ {
+		x.free = append(x.free, uint64(i*XskFrameSize))
+	}
+	sa := sockaddrXdp{
+		Family:  afXdp,
+		Flags:   xdpCopy,
+		Ifindex: uint32(ifindex),
+		QueueId: uint32(queue),
+	}
+	_, _, errno = syscall.Syscall(syscall.SYS_BIND, uintptr(x.fd),
+		uintptr(unsafe.Pointer(&sa)), unsafe.Sizeof(sa))
+	if errno != 0 {
+		return errno
+	}
+	return nil
+}
+
+func (x *Xsk) setsockopt(opt uintptr, p unsafe.Pointer, n uintptr) error {
+	_, _, errno := syscall.Syscall6(syscall.SYS_SETSOCKOPT, uintptr(x.fd),
+		solXdp, opt, uintptr(p), n, 0)
+	if errno != 0 {
+		return errno
+	}
+	return nil
+}
+
+func (r *xskRing) mmap(fd int, off *xdpRingOffset, pgoff int64,
+	size int) (err error) {
+	r.mem, err = syscall.Mmap(fd, pgoff,
+		int(off.Desc)+(XskRingSize*size),
+		syscall.PROT_READ|syscall.PROT_WRITE,
+		syscall.MAP_SHARED|syscall.MAP_POPULATE)
+	if err != nil {
+		return
+	}
+	r.prod = (*uint32)(unsafe.Pointer(&r.mem[off.Producer]))
+	r.cons = (*uint32)(unsafe.Pointer(&r.mem[off.Consumer]))
+	r.desc = unsafe.Pointer(&r.mem[off.Desc])
+	return
+}
+
+func (r *xskRing) addr(i uint32) *uint64 {
+	i &= XskRingSize - 1
+	return (*uint64)(unsafe.Pointer(uintptr(r.desc) + uintptr(i*8)))
+}
+
+func (r *xskRing) xdpDesc(i uint32) *xdpDesc {
+	i &= XskRingSize - 1
+	return (*xdpDesc)(unsafe.Pointer(uintptr(r.desc) +
+		uintptr(i)*unsafe.Sizeof(xdpDesc{})))
+}
+
+// Fd returns the socket to poll for POLLIN.
+func (x *Xsk) Fd() int { return x.fd }
+
+// Rx calls f with each received frame, which is only valid during the call,
+// then returns the frames to the fill ring. It returns the number received.
+func (x *Xsk) Rx(f func([]byte)) int {
+	cons := *x.rx.cons
+	n := atomic.LoadUint32(x.rx.prod) - cons
+	fprod := *x.fr.prod
+	for i := uint32(0); i < n; i++ {
+		desc := x.rx.xdpDesc(cons + i)
+		f(x.umem[desc.Addr : desc.Addr+uint64(desc.Len)])
+		// the chunk of an rx frame always has room in the fill ring
+		*x.fr.addr(fprod + i) = desc.Addr &^ (XskFrameSize - 1)
+	}
+	atomic.StoreUint32(x.rx.cons, cons+n)
+	atomic.StoreUint32(x.fr.prod, fprod+n)
+	return int(n)
+}
+
+// Tx copies and marks an exception frame into the tx ring then kicks the
+// socket to send it through the mux.
+func (x *Xsk) Tx(b []byte) error {
+	x.complete()
+	if len(x.free) == 0 || len(b) > XskFrameSize {
+		return ErrXskFull
+	}
+	prod := *x.tx.prod
+	if prod-atomic.LoadUint32(x.tx.cons) >= XskRingSize {
+		return ErrXskFull
+	}
+	addr := x.free[len(x.free)-1]
+	x.free = x.free[:len(x.free)-1]
+	frame := x.umem[addr : addr+uint64(len(b))]
+	copy(frame, b)
+	if !isTrap(frame) {
+		frame[ETH_VLAN_TCI] |= VlanPrioMask >> 8
+	}
+	desc := x.tx.xdpDesc(prod)
+	desc.Addr = addr
+	desc.Len = uint32(len(b))
+	desc.Options = 0
+	atomic.StoreUint32(x.tx.prod, prod+1)
+	_, _, errno := syscall.Syscall6(syscall.SYS_SENDTO, uintptr(x.fd),
+		0, 0, syscall.MSG_DONTWAIT, 0, 0)
+	switch errno {
+	case 0, syscall.EAGAIN, syscall.EBUSY, syscall.ENOBUFS:
+		return nil
+	}
+	return errno
+}
+
+// reclaim the UMEM frames of sent tx
+func (x *Xsk) complete() {
+	cons := *x.cr.cons
+	n := atomic.LoadUint32(x.cr.prod) - cons
+	for i := uint32(0); i < n; i++ {
+		x.free = append(x.free, *x.cr.addr(cons + i))
+	}
+	atomic.StoreUint32(x.cr.cons, cons+n)
+}
+
+// Close unmaps the rings and UMEM then closes the socket.
+func (x *Xsk) Close() error {
+	for _, r := range []*xskRing{&x.rx, &x.tx, &x.fr, &x.cr} {
+		if r.mem != nil {
+			syscall.Munmap(r.mem)
+			r.mem = nil
+		}
+	}
+	err := syscall.Close(x.fd)
+	if x.umem != nil {
+		syscall.Munmap(x.umem)
+		x.umem = nil
+	}
+	return err
+}
+
+func xskmapUpdate(path string, queue, fd uint32) error {
+	if sysBpf == 0 {
+		return syscall.ENOSYS
+	}
+	pathname, err := syscall.BytePtrFromString(path)
+	if err != nil {
+		return err
+	}
+	get := struct {
+		Pathname         uint64
+		BpfFd, FileFlags uint32
+	}{Pathname: uint64(uintptr(unsafe.Pointer(pathname)))}
+	mapfd, _, errno := syscall.Syscall(sysBpf, bpfObjGet,
+		uintptr(unsafe.Pointer(&get)), unsafe.Sizeof(get))
+	if errno != 0 {
+		return errno
+	}
+	defer syscall.Close(int(mapfd))
+	update := struct {
+		MapFd, _   uint32
+		Key, Value uint64
+		Flags      uint64
+	}{
+		MapFd: uint32(mapfd),
+		Key:   uint64(uintptr(unsafe.Pointer(&queue))),
+		Value: uint64(uintptr(unsafe.Pointer(&fd))),
+	}
+	_, _, errno = syscall.Syscall(sysBpf, bpfMapUpdateElem,
+		uintptr(unsafe.Pointer(&update)), unsafe.Sizeof(update))
+	if errno != 0 {
+		return errno
+	}
+	return nil
+}
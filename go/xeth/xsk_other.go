@@ -0,0 +1,10 @@
+// Copyright © 2021 Platina Systems, Inc. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+// +build !amd64,!arm64
+
+package xeth
+
+// Without SYS_BPF, OpenXsk can't update an XSKMAP.
+const sysBpf = 0